@@ -1,213 +1,3062 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
 
 // Global Data and Constants
 #define DATA_FILENAME "dataset.txt"
+#define DATA_BIN_FILENAME "dataset.bin"
+#define DATA_BIN_TEMP_FILENAME "dataset.bin.tmp"
+#define DATA_JOURNAL_FILENAME "dataset.journal"
 
-// Dynamic array pointer and size
+// Binary dataset format: a fixed header followed by count little-endian
+// int32 values. Header layout (all fields little-endian):
+//   0  magic "MENG"     4  u16 version   6  u16 element type
+//   8  u32 header size  12 u32 reserved  16 u64 count   24 u64 checksum
+#define BIN_MAGIC "MENG"
+#define BIN_VERSION 1
+#define BIN_TYPE_INT32 1
+#define BIN_HEADER_SIZE 32
+
+// Change journal: a save appends the edits made since the previous save to
+// DATA_JOURNAL_FILENAME instead of rewriting DATA_BIN_FILENAME. Header:
+//   0  magic "MJNL"     4  u16 version   6  u16 reserved
+//   8  u32 header size  12 u32 reserved  16 u64 snapshot count
+//   24 u64 snapshot checksum
+// The snapshot fields name the DATA_BIN_FILENAME the journal extends. Each
+// record is u32 op, u32 length, length u32 operands and a u64 Fletcher-64
+// of the preceding words. A save writes a new snapshot instead once the
+// journal would outgrow both half the snapshot and JOURNAL_MIN_COMPACT_BYTES.
+#define JOURNAL_MAGIC "MJNL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_SIZE 32
+#define JOURNAL_MIN_COMPACT_BYTES (1 << 20)
+
+// Streaming batch mode: bytes read per fread and ints aggregated per chunk
+#define STREAM_READ_BYTES (1 << 20)
+#define STREAM_CHUNK_VALUES 65536
+
+// Sort engine tuning: below RADIX_MIN_SIZE a comparison sort wins, and inputs
+// of at least SORT_PARALLEL_MIN_SIZE are split across all cores
+#define INSERTION_SORT_MAX 16
+#define RADIX_MIN_SIZE 256
+#define SORT_PARALLEL_MIN_SIZE (1 << 20)
+
+// Worker pool: arrays smaller than PARALLEL_MIN_SIZE stay on the calling
+// thread, larger ones are cut into TASKS_PER_THREAD slices per thread
+#define MAX_POOL_THREADS 64
+#define PARALLEL_MIN_SIZE (1 << 18)
+#define TASKS_PER_THREAD 4
+
+// Order statistics: at most MAX_PERCENTILES per request; histograms have
+// at most MAX_HISTOGRAM_BUCKETS buckets
+#define MAX_PERCENTILES 16
+#define MAX_HISTOGRAM_BUCKETS 100
+#define HISTOGRAM_BAR_WIDTH 40
+
+// Streaming sketches: KLL compactor size (rank error roughly 1.7/k) and
+// HyperLogLog precision (2^p registers, about 1.04/sqrt(2^p) error)
+#define SKETCH_K 256
+#define SKETCH_MAX_LEVELS 48
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+// Query pipeline: stages per query and length of a query string
+#define MAX_QUERY_STAGES 16
+#define MAX_QUERY_LENGTH 256
+
+// Dataset container: capacity doubles on growth and halves once the dataset
+// drops below a quarter of it, but never below MIN_DATA_CAPACITY
+#define MIN_DATA_CAPACITY 16
+
+// Dynamic array pointer, size and allocated capacity
 int *dataset = NULL;
 int data_size = 0;
+int data_capacity = 0;
+
+// Set while dataset points into a private mapping of DATA_BIN_FILENAME
+// rather than a malloc'd block
+void *data_map = NULL;
+size_t data_map_length = 0;
+
+// Function Pointer Definition
+typedef void (*OperationFunc)(int*, int);
+
+// Running aggregates produced by the fused reduction kernel: everything the
+// sum, average and min/max operations need, from a single pass
+typedef struct {
+    long long sum;
+    long long count;
+    int min;
+    int max;
+} DataSummary;
+
+// Reduction kernel: summarizes size ints starting at data into out
+typedef void (*ReduceKernel)(const int*, int, DataSummary*);
+
+// Aggregates of the global dataset kept current across mutations. valid is
+// 0 until first computed; extremes_valid drops to 0 when a delete removes
+// the current min or max, and they are recomputed on the next request.
+typedef struct {
+    DataSummary summary;
+    int valid;
+    int extremes_valid;
+} StatsCache;
+
+// Mergeable KLL quantile sketch. Level h holds items standing for 2^h
+// input values; a full level is sorted and every other item is promoted.
+typedef struct {
+    int *levels[SKETCH_MAX_LEVELS];
+    int sizes[SKETCH_MAX_LEVELS];
+    int allocated[SKETCH_MAX_LEVELS];
+    int num_levels;
+    int total_size;
+    int total_capacity;
+    long long n;
+    unsigned long long rng;
+} QuantileSketch;
+
+// Mergeable distinct-count estimator
+typedef struct {
+    unsigned char registers[HLL_REGISTERS];
+} HyperLogLog;
+
+// Value predicate for batch deletion, e.g. { COND_BETWEEN, 10, 20 }
+typedef enum {
+    COND_LESS,
+    COND_LESS_EQUAL,
+    COND_GREATER,
+    COND_GREATER_EQUAL,
+    COND_EQUAL,
+    COND_NOT_EQUAL,
+    COND_BETWEEN,   // a <= x <= b
+    COND_OUTSIDE    // x < a || x > b
+} ConditionOp;
+
+typedef struct {
+    ConditionOp op;
+    int a;
+    int b;
+} ValueCondition;
+
+// Journal record types; operands follow in parentheses
+typedef enum {
+    JOURNAL_APPEND = 1,     // (values...)
+    JOURNAL_DELETE_RANGE,   // (from, to)
+    JOURNAL_DELETE_IF,      // (condition op, a, b)
+    JOURNAL_SORT            // ()
+} JournalOp;
+
+// Posting list of one distinct value in the value index. A single position
+// is stored inline; capacity > 0 means positions live in list.
+typedef struct {
+    int value;
+    int state;      // SLOT_EMPTY, SLOT_LIVE or SLOT_DELETED
+    int count;
+    int capacity;
+    union {
+        int single;
+        int *list;
+    } pos;
+} IndexEntry;
+
+#define SLOT_EMPTY 0
+#define SLOT_LIVE 1
+#define SLOT_DELETED 2
+
+// Open-addressing hash index from value to the ascending positions holding
+// it. When stale it is rebuilt on the next lookup.
+typedef struct {
+    IndexEntry *slots;
+    int capacity;   // power of two
+    int live;
+    int deleted;
+    int enabled;
+    int stale;
+} ValueIndex;
+
+// Query pipeline: filter and map stages applied left to right to every
+// value, then one aggregate. Values are widened to long long; a map or sum
+// that still overflows stops the query, which then reports the overflow
+// instead of a result.
+typedef int (*ValuePredicate)(long long value, void *ctx);
+
+typedef enum {
+    STAGE_FILTER,
+    STAGE_MAP
+} StageKind;
+
+typedef enum {
+    MAP_ADD,
+    MAP_SUBTRACT,
+    MAP_MULTIPLY,
+    MAP_DIVIDE,
+    MAP_MODULO,
+    MAP_NEGATE,
+    MAP_ABS,
+    MAP_SQUARE
+} MapOp;
+
+typedef enum {
+    AGG_SUM,
+    AGG_COUNT,
+    AGG_MIN,
+    AGG_MAX,
+    AGG_AVG
+} QueryAggregate;
+
+typedef struct {
+    StageKind kind;
+    ValueCondition cond;     // filter: used when pred is NULL
+    ValuePredicate pred;     // filter: custom predicate
+    void *pred_ctx;
+    MapOp map;
+    long long operand;
+} QueryStage;
+
+typedef struct {
+    QueryStage stages[MAX_QUERY_STAGES];
+    int num_stages;
+    QueryAggregate aggregate;
+} Query;
+
+// Everything a query's aggregate can ask for, over the values that made it
+// through every filter
+typedef struct {
+    long long count;
+    long long sum;
+    long long min;
+    long long max;
+    int overflow;   // a map or the sum left the range of long long
+} QueryResult;
+
+// Unit of work for the thread pool: called once per task index
+typedef void (*PoolTaskFunc)(void*, int);
+
+// Persistent worker pool. The calling thread takes part in every run, so a
+// pool with zero workers still completes all tasks serially.
+typedef struct {
+    pthread_t threads[MAX_POOL_THREADS];
+    int num_workers;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    PoolTaskFunc func;
+    void *arg;
+    int num_tasks;
+    int next_task;
+    int pending;        // tasks handed out but not finished yet
+    int busy;           // a run is in progress (runs do not nest)
+    int shutting_down;
+} ThreadPool;
+
+// Buffered reader that parses whitespace separated integers from a FILE
+// without holding more than STREAM_READ_BYTES of the input in memory
+typedef struct {
+    FILE *fp;
+    char *buf;
+    size_t len;
+    size_t pos;
+    int eof;
+    int in_oversized;   // discarding a token longer than the whole buffer
+    long long skipped;  // tokens that were not valid 32-bit integers
+} IntReader;
+
+
+// Fused Reduction Kernel
+// One pass yields sum, count, min and max. A SIMD variant is picked at
+// startup from the CPU features; MATH_ENGINE_SIMD=scalar|sse2|avx2|avx512
+// forces a specific one.
+
+void summary_init(DataSummary *s) {
+    s->sum = 0;
+    s->count = 0;
+    s->min = INT_MAX;
+    s->max = INT_MIN;
+}
+
+// Folds a partial summary into a running one
+void summary_merge(DataSummary *into, const DataSummary *part) {
+    into->sum += part->sum;
+    into->count += part->count;
+    if (part->min < into->min) into->min = part->min;
+    if (part->max > into->max) into->max = part->max;
+}
+
+static void reduce_scalar(const int *data, int size, DataSummary *out) {
+    summary_init(out);
+    for (int i = 0; i < size; i++) {
+        out->sum += data[i];
+        if (data[i] < out->min) out->min = data[i];
+        if (data[i] > out->max) out->max = data[i];
+    }
+    out->count = size;
+}
+
+#ifdef HAVE_X86_SIMD
+// Lanes are widened to 64 bits before summing, so the sum cannot overflow
+// before the final horizontal add
+__attribute__((target("sse2")))
+static void reduce_sse2(const int *data, int size, DataSummary *out) {
+    __m128i vsum = _mm_setzero_si128();
+    __m128i vmin = _mm_set1_epi32(INT_MAX);
+    __m128i vmax = _mm_set1_epi32(INT_MIN);
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i sign = _mm_srai_epi32(v, 31);
+        vsum = _mm_add_epi64(vsum, _mm_unpacklo_epi32(v, sign));
+        vsum = _mm_add_epi64(vsum, _mm_unpackhi_epi32(v, sign));
+        // SSE2 has no 32-bit min/max: select through compare masks
+        __m128i lt = _mm_cmplt_epi32(v, vmin);
+        vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+        __m128i gt = _mm_cmpgt_epi32(v, vmax);
+        vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+    }
+
+    long long sums[2];
+    int mins[4], maxs[4];
+    _mm_storeu_si128((__m128i *)sums, vsum);
+    _mm_storeu_si128((__m128i *)mins, vmin);
+    _mm_storeu_si128((__m128i *)maxs, vmax);
+
+    reduce_scalar(data + i, size - i, out);
+    out->sum += sums[0] + sums[1];
+    for (int lane = 0; lane < 4; lane++) {
+        if (mins[lane] < out->min) out->min = mins[lane];
+        if (maxs[lane] > out->max) out->max = maxs[lane];
+    }
+    out->count = size;
+}
+
+__attribute__((target("avx2")))
+static void reduce_avx2(const int *data, int size, DataSummary *out) {
+    __m256i vsum = _mm256_setzero_si256();
+    __m256i vmin = _mm256_set1_epi32(INT_MAX);
+    __m256i vmax = _mm256_set1_epi32(INT_MIN);
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+
+    long long sums[4];
+    int mins[8], maxs[8];
+    _mm256_storeu_si256((__m256i *)sums, vsum);
+    _mm256_storeu_si256((__m256i *)mins, vmin);
+    _mm256_storeu_si256((__m256i *)maxs, vmax);
+
+    reduce_scalar(data + i, size - i, out);
+    out->sum += sums[0] + sums[1] + sums[2] + sums[3];
+    for (int lane = 0; lane < 8; lane++) {
+        if (mins[lane] < out->min) out->min = mins[lane];
+        if (maxs[lane] > out->max) out->max = maxs[lane];
+    }
+    out->count = size;
+}
+
+__attribute__((target("avx512f")))
+static void reduce_avx512(const int *data, int size, DataSummary *out) {
+    __m512i vsum = _mm512_setzero_si512();
+    __m512i vmin = _mm512_set1_epi32(INT_MAX);
+    __m512i vmax = _mm512_set1_epi32(INT_MIN);
+    int i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(data + i));
+        vsum = _mm512_add_epi64(vsum, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        vsum = _mm512_add_epi64(vsum, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+        vmin = _mm512_min_epi32(vmin, v);
+        vmax = _mm512_max_epi32(vmax, v);
+    }
+
+    reduce_scalar(data + i, size - i, out);
+    out->sum += _mm512_reduce_add_epi64(vsum);
+    int lane_min = _mm512_reduce_min_epi32(vmin);
+    int lane_max = _mm512_reduce_max_epi32(vmax);
+    if (lane_min < out->min) out->min = lane_min;
+    if (lane_max > out->max) out->max = lane_max;
+    out->count = size;
+}
+#endif
+
+typedef struct {
+    const char *name;
+    ReduceKernel kernel;
+} KernelChoice;
+
+ReduceKernel reduce_kernel = NULL;
+pthread_once_t reduce_kernel_once = PTHREAD_ONCE_INIT;
+const char *reduce_kernel_name = "scalar";
+
+static int kernel_supported(const char *name) {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (strcmp(name, "avx512") == 0) return __builtin_cpu_supports("avx512f");
+    if (strcmp(name, "avx2") == 0) return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "sse2") == 0) return __builtin_cpu_supports("sse2");
+#endif
+    return strcmp(name, "scalar") == 0;
+}
+
+// Picks the widest kernel the CPU supports (best first in the table)
+static void choose_reduce_kernel(void) {
+    KernelChoice choices[] = {
+#ifdef HAVE_X86_SIMD
+        { "avx512", reduce_avx512 },
+        { "avx2",   reduce_avx2 },
+        { "sse2",   reduce_sse2 },
+#endif
+        { "scalar", reduce_scalar }
+    };
+    int num_choices = sizeof(choices) / sizeof(choices[0]);
+    const char *forced = getenv("MATH_ENGINE_SIMD");
+
+    reduce_kernel = reduce_scalar;
+    reduce_kernel_name = "scalar";
+    for (int i = 0; i < num_choices; i++) {
+        if (forced != NULL && strcmp(forced, choices[i].name) != 0) continue;
+        if (kernel_supported(choices[i].name)) {
+            reduce_kernel = choices[i].kernel;
+            reduce_kernel_name = choices[i].name;
+            return;
+        }
+    }
+    if (forced != NULL) {
+        fprintf(stderr, "Warning: SIMD kernel '%s' unavailable, using scalar.\n", forced);
+    }
+}
+
+// Chooses the kernel once, whichever thread summarizes first
+void select_reduce_kernel() {
+    pthread_once(&reduce_kernel_once, choose_reduce_kernel);
+}
+
+void summarize(const int *data, int size, DataSummary *out) {
+    select_reduce_kernel();
+    reduce_kernel(data, size, out);
+}
+
+// Adds a block of values to a running summary
+void summary_update(DataSummary *s, const int *data, int size) {
+    DataSummary part;
+    summarize(data, size, &part);
+    summary_merge(s, &part);
+}
+
+// Thread Pool
+
+ThreadPool pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER
+};
+int pool_started = 0;
+
+int available_cores() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return 1;
+    return cores > MAX_POOL_THREADS ? MAX_POOL_THREADS : (int)cores;
+}
+
+// Claims and runs tasks until none are left. Called with pool.lock held.
+static void pool_drain(void) {
+    while (pool.next_task < pool.num_tasks) {
+        int task = pool.next_task++;
+        PoolTaskFunc func = pool.func;
+        void *arg = pool.arg;
+        pthread_mutex_unlock(&pool.lock);
+        func(arg, task);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0) pthread_cond_broadcast(&pool.work_done);
+    }
+}
+
+static void *pool_worker(void *unused) {
+    (void)unused;
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.shutting_down) {
+        if (pool.next_task < pool.num_tasks) {
+            pool_drain();
+        } else {
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Starts one worker per extra core. Workers that fail to start are simply
+// not counted; the caller picks up their share.
+static void pool_start(void) {
+    int wanted = available_cores() - 1;
+    for (int i = 0; i < wanted; i++) {
+        if (pthread_create(&pool.threads[pool.num_workers], NULL, pool_worker, NULL) != 0) break;
+        pool.num_workers++;
+    }
+    pool_started = 1;
+}
+
+// Number of threads (workers plus caller) that execute a pool run
+int pool_size() {
+    if (!pool_started) pool_start();
+    return pool.num_workers + 1;
+}
+
+// Runs func(arg, 0..num_tasks-1) across the pool and returns when all tasks
+// have finished. A run issued while another is active executes serially.
+void pool_run(PoolTaskFunc func, void *arg, int num_tasks) {
+    if (!pool_started) pool_start();
+
+    pthread_mutex_lock(&pool.lock);
+    if (pool.busy || pool.num_workers == 0) {
+        pthread_mutex_unlock(&pool.lock);
+        for (int i = 0; i < num_tasks; i++) func(arg, i);
+        return;
+    }
+    pool.busy = 1;
+    pool.func = func;
+    pool.arg = arg;
+    pool.num_tasks = num_tasks;
+    pool.next_task = 0;
+    pool.pending = num_tasks;
+    pthread_cond_broadcast(&pool.work_ready);
+
+    pool_drain();
+    while (pool.pending > 0) pthread_cond_wait(&pool.work_done, &pool.lock);
+    pool.busy = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void pool_shutdown() {
+    if (!pool_started) return;
+    pthread_mutex_lock(&pool.lock);
+    pool.shutting_down = 1;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.num_workers; i++) pthread_join(pool.threads[i], NULL);
+    pool.num_workers = 0;
+    pool.shutting_down = 0;
+    pool_started = 0;
+}
+
+// Number of slices to cut size elements into: 1 below the threshold
+int parallel_tasks(int size) {
+    if (size < PARALLEL_MIN_SIZE) return 1;
+    int tasks = pool_size() * TASKS_PER_THREAD;
+    return tasks > size ? size : tasks;
+}
+
+// Bounds of slice task out of tasks over size elements
+static void slice_bounds(int size, int tasks, int task, int *begin, int *end) {
+    *begin = (int)((long long)size * task / tasks);
+    *end = (int)((long long)size * (task + 1) / tasks);
+}
+
+// Parallel Reductions
+
+typedef struct {
+    const int *data;
+    int size;
+    int tasks;
+    DataSummary *parts;
+} SummaryJob;
+
+static void summarize_slice(void *arg, int task) {
+    SummaryJob *job = (SummaryJob *)arg;
+    int begin, end;
+    slice_bounds(job->size, job->tasks, task, &begin, &end);
+    summarize(job->data + begin, end - begin, &job->parts[task]);
+}
+
+// Same result as summarize(), computed across the pool for large arrays.
+// Partials are merged in slice order, so the result never depends on timing.
+void parallel_summarize(const int *data, int size, DataSummary *out) {
+    int tasks = parallel_tasks(size);
+    DataSummary *parts = tasks > 1 ? (DataSummary*)malloc(tasks * sizeof(DataSummary)) : NULL;
+    if (parts == NULL) {
+        summarize(data, size, out);
+        return;
+    }
+
+    SummaryJob job = { data, size, tasks, parts };
+    pool_run(summarize_slice, &job, tasks);
+
+    summary_init(out);
+    for (int i = 0; i < tasks; i++) summary_merge(out, &parts[i]);
+    free(parts);
+}
+
+// Integer Parsing
+
+// Parses [s, end) as an optionally signed decimal int. Returns 0 if the
+// token is not a number or does not fit in an int.
+int parse_int_token(const char *s, const char *end, int *out) {
+    int negative = 0;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = (*s == '-');
+        s++;
+    }
+    if (s == end) return 0;
+
+    long long value = 0;
+    for (; s < end; s++) {
+        unsigned digit = (unsigned)(*s - '0');
+        if (digit > 9) return 0;
+        value = value * 10 + digit;
+        if (value > (long long)INT_MAX + 1) return 0;
+    }
+    if (negative) value = -value;
+    if (value > INT_MAX) return 0;
+
+    *out = (int)value;
+    return 1;
+}
+
+static int is_separator(char c) {
+    return (unsigned char)c <= ' ';
+}
+
+// Keeps the unconsumed tail of the buffer and reads more input after it
+static int reader_refill(IntReader *r) {
+    size_t rest = r->len - r->pos;
+    memmove(r->buf, r->buf + r->pos, rest);
+    r->len = rest;
+    r->pos = 0;
+
+    size_t got = fread(r->buf + r->len, 1, STREAM_READ_BYTES - r->len, r->fp);
+    r->len += got;
+    if (got == 0) r->eof = 1;
+    return got > 0;
+}
+
+int int_reader_open(IntReader *r, FILE *fp) {
+    r->fp = fp;
+    r->buf = (char*)malloc(STREAM_READ_BYTES);
+    r->len = 0;
+    r->pos = 0;
+    r->eof = 0;
+    r->in_oversized = 0;
+    r->skipped = 0;
+    if (r->buf == NULL) return 0;
+
+    // Files written by save_results() start with a DATA_SIZE=N header line
+    reader_refill(r);
+    if (r->len >= 10 && memcmp(r->buf, "DATA_SIZE=", 10) == 0) {
+        while (r->pos == r->len || r->buf[r->pos] != '\n') {
+            if (r->pos < r->len) r->pos++;
+            else if (!reader_refill(r)) break;
+        }
+    }
+    return 1;
+}
+
+void int_reader_close(IntReader *r) {
+    free(r->buf);
+    r->buf = NULL;
+}
+
+// Parses up to max integers into out. Returns how many were parsed; 0 means
+// the input is exhausted.
+int int_reader_fill(IntReader *r, int *out, int max) {
+    int n = 0;
+    while (n < max) {
+        size_t start = r->pos;
+        while (r->pos < r->len && is_separator(r->buf[r->pos])) r->pos++;
+        // An oversized token that filled the buffer may end right at its end
+        if (r->pos > start) r->in_oversized = 0;
+        if (r->pos == r->len) {
+            if (r->eof || !reader_refill(r)) break;
+            continue;
+        }
+
+        size_t end = r->pos;
+        while (end < r->len && !is_separator(r->buf[end])) end++;
+
+        // Token may continue past the buffer: pull in more input first
+        if (end == r->len && !r->eof) {
+            if (r->pos == 0 && r->len == STREAM_READ_BYTES) {
+                // A single token filling the whole buffer is garbage
+                r->pos = r->len;
+                if (!r->in_oversized) r->skipped++;
+                r->in_oversized = 1;
+            } else {
+                reader_refill(r);
+            }
+            continue;
+        }
+
+        if (r->in_oversized) {
+            r->in_oversized = 0;
+        } else if (parse_int_token(r->buf + r->pos, r->buf + end, &out[n])) {
+            n++;
+        } else {
+            r->skipped++;
+        }
+        r->pos = end;
+    }
+    return n;
+}
+
+// Value Lookup
+// search_value picks the cheapest strategy available: binary search while
+// the dataset is sorted, the hash index when enabled, a parallel scan
+// otherwise.
+
+// Lookup state for search_value: data_sorted is maintained by every
+// mutation, the value index only while enabled (menu option 14)
+int data_sorted = 1;
+ValueIndex value_index = { 0 };
+
+int condition_matches(const ValueCondition *cond, long long value) {
+    switch (cond->op) {
+        case COND_LESS:          return value < cond->a;
+        case COND_LESS_EQUAL:    return value <= cond->a;
+        case COND_GREATER:       return value > cond->a;
+        case COND_GREATER_EQUAL: return value >= cond->a;
+        case COND_EQUAL:         return value == cond->a;
+        case COND_NOT_EQUAL:     return value != cond->a;
+        case COND_BETWEEN:       return value >= cond->a && value <= cond->b;
+        case COND_OUTSIDE:       return value < cond->a || value > cond->b;
+    }
+    return 0;
+}
+
+int is_sorted_run(const int *data, int size) {
+    for (int i = 1; i < size; i++) {
+        if (data[i] < data[i - 1]) return 0;
+    }
+    return 1;
+}
+
+// First index whose value is >= value
+int lower_bound(const int *data, int size, int value) {
+    int lo = 0, hi = size;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (data[mid] < value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// First index whose value is > value
+int upper_bound(const int *data, int size, int value) {
+    int lo = 0, hi = size;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (data[mid] <= value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static unsigned hash_value(int value, int capacity) {
+    return ((unsigned)value * 2654435761u) & (unsigned)(capacity - 1);
+}
+
+static int *entry_positions(IndexEntry *e) {
+    return e->capacity > 0 ? e->pos.list : &e->pos.single;
+}
+
+static void entry_free(IndexEntry *e) {
+    if (e->capacity > 0) free(e->pos.list);
+    e->capacity = 0;
+    e->count = 0;
+}
+
+void index_clear() {
+    for (int i = 0; i < value_index.capacity; i++) entry_free(&value_index.slots[i]);
+    free(value_index.slots);
+    value_index.slots = NULL;
+    value_index.capacity = 0;
+    value_index.live = 0;
+    value_index.deleted = 0;
+}
+
+// Slot holding value, or NULL
+static IndexEntry *index_find(int value) {
+    if (value_index.capacity == 0) return NULL;
+    unsigned mask = value_index.capacity - 1;
+    for (unsigned i = hash_value(value, value_index.capacity); ; i = (i + 1) & mask) {
+        IndexEntry *e = &value_index.slots[i];
+        if (e->state == SLOT_EMPTY) return NULL;
+        if (e->state == SLOT_LIVE && e->value == value) return e;
+    }
+}
+
+// Rehashes into a table sized for the live entries, dropping tombstones
+static int index_rehash(int min_live) {
+    int capacity = 16;
+    while (capacity < 2 * min_live) capacity *= 2;
+    IndexEntry *slots = (IndexEntry*)calloc(capacity, sizeof(IndexEntry));
+    if (slots == NULL) return 0;
+
+    for (int i = 0; i < value_index.capacity; i++) {
+        IndexEntry *old = &value_index.slots[i];
+        if (old->state != SLOT_LIVE) continue;
+        unsigned j = hash_value(old->value, capacity);
+        while (slots[j].state != SLOT_EMPTY) j = (j + 1) & (capacity - 1);
+        slots[j] = *old;
+    }
+    free(value_index.slots);
+    value_index.slots = slots;
+    value_index.capacity = capacity;
+    value_index.deleted = 0;
+    return 1;
+}
+
+// Records that value sits at position, which must be larger than every
+// position already indexed for it
+static int index_insert(int value, int position) {
+    if (2 * (value_index.live + value_index.deleted + 1) > value_index.capacity &&
+        !index_rehash(value_index.live + 1)) {
+        return 0;
+    }
+
+    IndexEntry *e = index_find(value);
+    if (e == NULL) {
+        unsigned mask = value_index.capacity - 1;
+        unsigned i = hash_value(value, value_index.capacity);
+        while (value_index.slots[i].state == SLOT_LIVE) i = (i + 1) & mask;
+        e = &value_index.slots[i];
+        if (e->state == SLOT_DELETED) value_index.deleted--;
+        e->state = SLOT_LIVE;
+        e->value = value;
+        e->count = 1;
+        e->capacity = 0;
+        e->pos.single = position;
+        value_index.live++;
+        return 1;
+    }
+
+    if (e->count == 1 && e->capacity == 0) {
+        int *list = (int*)malloc(4 * sizeof(int));
+        if (list == NULL) return 0;
+        list[0] = e->pos.single;
+        e->pos.list = list;
+        e->capacity = 4;
+    } else if (e->count == e->capacity) {
+        int *list = (int*)realloc(e->pos.list, 2 * e->capacity * sizeof(int));
+        if (list == NULL) return 0;
+        e->pos.list = list;
+        e->capacity *= 2;
+    }
+    e->pos.list[e->count++] = position;
+    return 1;
+}
+
+// Drops the index contents; the next lookup rebuilds it
+void index_invalidate() {
+    if (!value_index.enabled) return;
+    index_clear();
+    value_index.stale = 1;
+}
+
+void index_build(const int *data, int size) {
+    index_clear();
+    value_index.stale = 0;
+    for (int i = 0; i < size; i++) {
+        if (!index_insert(data[i], i)) {
+            printf("Warning: Not enough memory for the value index; disabling it.\n");
+            index_clear();
+            value_index.enabled = 0;
+            return;
+        }
+    }
+}
+
+// Keeps the index in step with values appended at first_position
+void index_on_append(const int *values, int count, int first_position) {
+    if (!value_index.enabled || value_index.stale) return;
+    for (int i = 0; i < count; i++) {
+        if (!index_insert(values[i], first_position + i)) {
+            index_invalidate();
+            return;
+        }
+    }
+}
+
+// Keeps the index in step with removal of positions [from, to): drops them
+// and shifts every later position down, in one pass over the postings
+void index_on_delete_range(int from, int to) {
+    if (!value_index.enabled || value_index.stale) return;
+    int removed = to - from;
+    for (int i = 0; i < value_index.capacity; i++) {
+        IndexEntry *e = &value_index.slots[i];
+        if (e->state != SLOT_LIVE) continue;
+
+        int *positions = entry_positions(e);
+        int kept = 0;
+        for (int j = 0; j < e->count; j++) {
+            int p = positions[j];
+            if (p < from) positions[kept++] = p;
+            else if (p >= to) positions[kept++] = p - removed;
+        }
+        e->count = kept;
+        if (kept == 0) {
+            entry_free(e);
+            e->state = SLOT_DELETED;
+            value_index.live--;
+            value_index.deleted++;
+        }
+    }
+}
+
+typedef struct {
+    const int *data;
+    int size;
+    int tasks;
+    const ValueCondition *cond;
+    int *counts;     // matches per slice, then the slice's output offset
+    int *positions;  // NULL during the counting pass
+} SearchJob;
+
+static void search_slice(void *arg, int task) {
+    SearchJob *job = (SearchJob *)arg;
+    int begin, end;
+    slice_bounds(job->size, job->tasks, task, &begin, &end);
+    if (job->positions == NULL) {
+        int count = 0;
+        for (int i = begin; i < end; i++) count += condition_matches(job->cond, job->data[i]);
+        job->counts[task] = count;
+    } else {
+        int out = job->counts[task];
+        for (int i = begin; i < end; i++) {
+            if (condition_matches(job->cond, job->data[i])) job->positions[out++] = i;
+        }
+    }
+}
+
+// Collects every index whose value matches cond, in ascending order, with a
+// parallel scan. Returns the number of matches (or -1 if out of memory);
+// *positions must be freed.
+int find_matches(const int *data, int size, const ValueCondition *cond, int **positions) {
+    int tasks = parallel_tasks(size);
+    int *counts = (int*)malloc(tasks * sizeof(int));
+    if (counts == NULL) return -1;
+
+    // Count per slice, turn counts into output offsets, then fill
+    SearchJob job = { data, size, tasks, cond, counts, NULL };
+    pool_run(search_slice, &job, tasks);
+    int total = 0;
+    for (int i = 0; i < tasks; i++) {
+        int count = counts[i];
+        counts[i] = total;
+        total += count;
+    }
+
+    *positions = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    if (*positions == NULL) {
+        free(counts);
+        return -1;
+    }
+    if (total > 0) {
+        job.positions = *positions;
+        pool_run(search_slice, &job, tasks);
+    }
+    free(counts);
+    return total;
+}
+
+// Statistics Cache
+// Keeps sum/count/min/max of the global dataset so options 4-6 are O(1).
+
+StatsCache data_stats = { { 0, 0, INT_MAX, INT_MIN }, 1, 1 };
+
+void stats_invalidate() {
+    data_stats.valid = 0;
+}
+
+// Fills out with the summary of the global dataset, recomputing only what a
+// previous mutation invalidated
+void dataset_stats(DataSummary *out) {
+    if (!data_stats.valid || !data_stats.extremes_valid) {
+        parallel_summarize(dataset, data_size, &data_stats.summary);
+        data_stats.valid = 1;
+        data_stats.extremes_valid = 1;
+    }
+    *out = data_stats.summary;
+}
+
+void stats_on_append(const int *values, int count) {
+    if (!data_stats.valid) return;
+    DataSummary part;
+    summarize(values, count, &part);
+    data_stats.summary.sum += part.sum;
+    data_stats.summary.count += part.count;
+    if (data_stats.extremes_valid) {
+        if (part.min < data_stats.summary.min) data_stats.summary.min = part.min;
+        if (part.max > data_stats.summary.max) data_stats.summary.max = part.max;
+    }
+}
+
+// Takes removed values out of the running totals. Only removing a value
+// equal to the current min or max forces those to be recomputed.
+void stats_on_remove(const DataSummary *removed) {
+    if (!data_stats.valid || removed->count == 0) return;
+    data_stats.summary.sum -= removed->sum;
+    data_stats.summary.count -= removed->count;
+    if (data_stats.summary.count == 0) {
+        summary_init(&data_stats.summary);
+        data_stats.extremes_valid = 1;
+    } else if (removed->min <= data_stats.summary.min || removed->max >= data_stats.summary.max) {
+        data_stats.extremes_valid = 0;
+    }
+}
+
+// Summary for an operation's input: served from the cache when the input is
+// the global dataset
+static void summary_for(int *data, int size, DataSummary *out) {
+    if (data == dataset && size == data_size) {
+        dataset_stats(out);
+    } else {
+        parallel_summarize(data, size, out);
+    }
+}
+
+// Change Journal
+// Every mutation of the global dataset is recorded here so the next save
+// only has to write what changed. Edits that cannot be expressed cheaply
+// (wholesale replacement, or more pending words than half the dataset)
+// drop the records and make the next save write a full snapshot instead.
+
+// Records not yet saved, as op, length, operands... words
+int *journal_pending = NULL;
+size_t journal_pending_words = 0;
+size_t journal_pending_capacity = 0;
+int journal_pending_records = 0;
+int journal_needs_snapshot = 0;
+int journal_replaying = 0;   // replayed edits are already on disk
+
+// The snapshot DATA_JOURNAL_FILENAME extends, and the journal's valid
+// length (0 while no journal has been written for it)
+int snapshot_present = 0;
+uint64_t snapshot_count = 0;
+uint64_t snapshot_checksum = 0;
+long long journal_file_bytes = 0;
+int journal_unapplied = 0;   // replay could not apply every record: saving would lose them
+
+static void journal_clear_pending(void) {
+    free(journal_pending);
+    journal_pending = NULL;
+    journal_pending_words = 0;
+    journal_pending_capacity = 0;
+    journal_pending_records = 0;
+}
+
+// Forgets the pending records; the next save writes a full snapshot
+void journal_require_snapshot() {
+    journal_clear_pending();
+    journal_needs_snapshot = 1;
+}
+
+static void journal_record(JournalOp op, const int *operands, int count) {
+    if (journal_replaying || journal_needs_snapshot) return;
+
+    size_t needed = journal_pending_words + 2 + (size_t)count;
+    if (needed > (size_t)data_size / 2 + STREAM_CHUNK_VALUES) {
+        journal_require_snapshot();
+        return;
+    }
+    if (needed > journal_pending_capacity) {
+        size_t new_capacity = journal_pending_capacity > 0 ? journal_pending_capacity : 64;
+        while (new_capacity < needed) new_capacity *= 2;
+        int *temp = (int*)realloc(journal_pending, new_capacity * sizeof(int));
+        if (temp == NULL) {
+            journal_require_snapshot();
+            return;
+        }
+        journal_pending = temp;
+        journal_pending_capacity = new_capacity;
+    }
+
+    journal_pending[journal_pending_words++] = op;
+    journal_pending[journal_pending_words++] = count;
+    if (count > 0) memcpy(journal_pending + journal_pending_words, operands, count * sizeof(int));
+    journal_pending_words += count;
+    journal_pending_records++;
+}
+
+// Dataset Container
+// Growth and deletion of dataset/data_size go through these functions.
+
+// Called whenever the dataset is replaced wholesale (load, cleanup)
+void dataset_replaced() {
+    data_sorted = is_sorted_run(dataset, data_size);
+    index_invalidate();
+    stats_invalidate();
+}
+
+void cleanup_memory() {
+    if (data_size > 0) journal_require_snapshot();
+    data_sorted = 1;
+    index_invalidate();
+    stats_invalidate();
+    if (data_map != NULL) {
+        munmap(data_map, data_map_length);
+        data_map = NULL;
+        dataset = NULL;
+        data_size = 0;
+        data_capacity = 0;
+    }
+    if (dataset != NULL) {
+        free(dataset);
+        dataset = NULL;
+        data_size = 0;
+        data_capacity = 0;
+        printf("\nDynamic memory freed.\n");
+    }
+}
+
+// Makes room for at least min_capacity elements, doubling the current
+// capacity so repeated appends cost amortized O(1). Returns 0 on failure.
+int dataset_reserve(int min_capacity) {
+    if (min_capacity <= data_capacity) return 1;
+
+    long long new_capacity = data_capacity > 0 ? data_capacity : MIN_DATA_CAPACITY;
+    while (new_capacity < min_capacity) new_capacity *= 2;
+    if (new_capacity > INT_MAX) new_capacity = INT_MAX;
+
+    // A mapped dataset cannot grow in place: move it to the heap first
+    if (data_map != NULL) {
+        int *copy = (int*)malloc((size_t)new_capacity * sizeof(int));
+        if (copy == NULL) return 0;
+        memcpy(copy, dataset, data_size * sizeof(int));
+        munmap(data_map, data_map_length);
+        data_map = NULL;
+        dataset = copy;
+        data_capacity = (int)new_capacity;
+        return 1;
+    }
+
+    int *temp = (int*)realloc(dataset, (size_t)new_capacity * sizeof(int));
+    if (temp == NULL) return 0;
+    dataset = temp;
+    data_capacity = (int)new_capacity;
+    return 1;
+}
+
+// Gives memory back once the dataset uses less than a quarter of it
+static void dataset_maybe_shrink(void) {
+    if (data_map != NULL) return;
+    if (data_capacity <= MIN_DATA_CAPACITY || data_size > data_capacity / 4) return;
+
+    int new_capacity = data_capacity / 2;
+    if (new_capacity < MIN_DATA_CAPACITY) new_capacity = MIN_DATA_CAPACITY;
+    int *temp = (int*)realloc(dataset, new_capacity * sizeof(int));
+    if (temp != NULL) {
+        dataset = temp;
+        data_capacity = new_capacity;
+    }
+}
+
+// Appends count values in one copy. Returns 0 if memory ran out.
+int dataset_append(const int *values, int count) {
+    if (count <= 0) return 1;
+    if (count > INT_MAX - data_size || !dataset_reserve(data_size + count)) return 0;
+    if (data_sorted) {
+        data_sorted = (data_size == 0 || values[0] >= dataset[data_size - 1]) &&
+                      is_sorted_run(values, count);
+    }
+    index_on_append(values, count, data_size);
+    stats_on_append(values, count);
+    journal_record(JOURNAL_APPEND, values, count);
+    memcpy(dataset + data_size, values, count * sizeof(int));
+    data_size += count;
+    return 1;
+}
+
+// Appends every integer read from fp, chunk by chunk. Returns the number of
+// values appended, or -1 if memory ran out part way through.
+long long dataset_append_stream(FILE *fp, long long *skipped) {
+    IntReader reader;
+    int *chunk = (int*)malloc(STREAM_CHUNK_VALUES * sizeof(int));
+    if (chunk == NULL || !int_reader_open(&reader, fp)) {
+        free(chunk);
+        return -1;
+    }
+
+    long long appended = 0;
+    int n;
+    while ((n = int_reader_fill(&reader, chunk, STREAM_CHUNK_VALUES)) > 0) {
+        if (!dataset_append(chunk, n)) {
+            appended = -1;
+            break;
+        }
+        appended += n;
+    }
+    if (skipped != NULL) *skipped = reader.skipped;
+
+    int_reader_close(&reader);
+    free(chunk);
+    return appended;
+}
+
+// Removes elements [from, to) with a single memmove
+int dataset_delete_range(int from, int to) {
+    if (from < 0 || to > data_size || from >= to) return 0;
+    if (data_stats.valid) {
+        DataSummary removed;
+        summarize(dataset + from, to - from, &removed);
+        stats_on_remove(&removed);
+    }
+    memmove(&dataset[from], &dataset[to], (data_size - to) * sizeof(int));
+    data_size -= to - from;
+    index_on_delete_range(from, to);
+    int range[2] = { from, to };
+    journal_record(JOURNAL_DELETE_RANGE, range, 2);
+    dataset_maybe_shrink();
+    return to - from;
+}
+
+// Removes every element matching cond in one compaction pass, keeping the
+// order of the survivors. Returns the number removed.
+int dataset_delete_if(const ValueCondition *cond) {
+    DataSummary removed_values;
+    summary_init(&removed_values);
+    int kept = 0;
+    for (int i = 0; i < data_size; i++) {
+        int value = dataset[i];
+        if (!condition_matches(cond, value)) {
+            dataset[kept++] = value;
+            continue;
+        }
+        removed_values.sum += value;
+        removed_values.count++;
+        if (value < removed_values.min) removed_values.min = value;
+        if (value > removed_values.max) removed_values.max = value;
+    }
+    int removed = data_size - kept;
+    data_size = kept;
+    stats_on_remove(&removed_values);
+    if (removed > 0) {
+        int condition[3] = { cond->op, cond->a, cond->b };
+        index_invalidate();
+        journal_record(JOURNAL_DELETE_IF, condition, 3);
+    }
+    dataset_maybe_shrink();
+    return removed;
+}
+
+void add_element() {
+    int value;
+    printf("Enter integer value to add: ");
+    if (scanf("%d", &value) != 1) {
+        printf("Invalid input.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    if (!dataset_append(&value, 1)) {
+        printf("Error: Failed to reallocate memory for new element.\n");
+        return;
+    }
+    printf("Element %d added successfully. New size: %d\n", value, data_size);
+}
+
+void delete_element() {
+    if (data_size == 0) {
+        printf("Dataset is empty.\n");
+        return;
+    }
+    int index;
+    printf("Enter index (0 to %d) of element to delete: ", data_size - 1);
+    if (scanf("%d", &index) != 1 || index < 0 || index >= data_size) {
+        printf("Invalid index.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    dataset_delete_range(index, index + 1);
+    printf("Element at index %d deleted. New size: %d\n", index, data_size);
+}
+
+// Reads values typed at the prompt until a non-number (e.g. "end")
+static long long append_from_prompt(void) {
+    int *chunk = (int*)malloc(STREAM_CHUNK_VALUES * sizeof(int));
+    if (chunk == NULL) return -1;
+
+    long long appended = 0;
+    int n = 0;
+    while (scanf("%d", &chunk[n]) == 1) {
+        if (++n == STREAM_CHUNK_VALUES) {
+            if (!dataset_append(chunk, n)) { free(chunk); return -1; }
+            appended += n;
+            n = 0;
+        }
+    }
+    while (getchar() != '\n');
+
+    if (!dataset_append(chunk, n)) { free(chunk); return -1; }
+    appended += n;
+    free(chunk);
+    return appended;
+}
+
+void bulk_append() {
+    char path[256];
+    printf("Enter file to append from ('-' to type values, finish with 'end'): ");
+    if (scanf("%255s", path) != 1) {
+        printf("Invalid input.\n");
+        return;
+    }
+
+    long long appended;
+    long long skipped = 0;
+    if (strcmp(path, "-") == 0) {
+        printf("Enter values separated by spaces or newlines:\n");
+        appended = append_from_prompt();
+    } else {
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+            perror("Error opening file for appending");
+            return;
+        }
+        appended = dataset_append_stream(fp, &skipped);
+        fclose(fp);
+    }
+
+    if (appended < 0) {
+        printf("Error: Ran out of memory while appending. New size: %d\n", data_size);
+        return;
+    }
+    printf("Appended %lld elements. New size: %d\n", appended, data_size);
+    if (skipped > 0) printf("Skipped %lld invalid tokens.\n", skipped);
+}
+
+void delete_range() {
+    if (data_size == 0) {
+        printf("Dataset is empty.\n");
+        return;
+    }
+    int from, to;
+    printf("Enter first and last index to delete (0 to %d): ", data_size - 1);
+    if (scanf("%d %d", &from, &to) != 2 || from < 0 || to >= data_size || from > to) {
+        printf("Invalid range.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    int removed = dataset_delete_range(from, to + 1);
+    printf("Deleted %d elements. New size: %d\n", removed, data_size);
+}
+
+void delete_by_condition() {
+    if (data_size == 0) {
+        printf("Dataset is empty.\n");
+        return;
+    }
+    printf("Delete values that are:\n");
+    printf("  1. < X   2. <= X   3. > X   4. >= X\n");
+    printf("  5. == X  6. != X   7. between A and B   8. outside A and B\n");
+    printf("Enter choice: ");
+
+    int choice;
+    ValueCondition cond = { COND_EQUAL, 0, 0 };
+    if (scanf("%d", &choice) != 1 || choice < 1 || choice > 8) {
+        printf("Invalid choice.\n");
+        while (getchar() != '\n');
+        return;
+    }
+    cond.op = (ConditionOp)(choice - 1);
+
+    if (cond.op == COND_BETWEEN || cond.op == COND_OUTSIDE) {
+        printf("Enter A and B: ");
+        if (scanf("%d %d", &cond.a, &cond.b) != 2 || cond.a > cond.b) {
+            printf("Invalid bounds.\n");
+            while (getchar() != '\n');
+            return;
+        }
+    } else {
+        printf("Enter X: ");
+        if (scanf("%d", &cond.a) != 1) {
+            printf("Invalid input.\n");
+            while (getchar() != '\n');
+            return;
+        }
+    }
+
+    int removed = dataset_delete_if(&cond);
+    printf("Deleted %d elements. New size: %d\n", removed, data_size);
+}
+
+// Function Pointers
+void compute_sum(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    DataSummary summary;
+    summary_for(data, size, &summary);
+    printf("--- Result ---\nTotal Sum: %lld\n", summary.sum);
+}
+
+void compute_average(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    DataSummary summary;
+    summary_for(data, size, &summary);
+    printf("--- Result ---\nAverage: %.2f\n", (double)summary.sum / summary.count);
+}
+
+void find_min_max(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    DataSummary summary;
+    summary_for(data, size, &summary);
+    printf("--- Result ---\nMinimum Value: %d\nMaximum Value: %d\n", summary.min, summary.max);
+}
+
+// Sort Engine
+// LSD radix sort on 32-bit keys with an introsort fallback for small inputs.
+// Large inputs are cut into one slice per pool thread, sorted concurrently and
+// then merged pairwise.
+
+static void insertion_sort(int *data, int size) {
+    for (int i = 1; i < size; i++) {
+        int value = data[i];
+        int j = i - 1;
+        while (j >= 0 && data[j] > value) {
+            data[j + 1] = data[j];
+            j--;
+        }
+        data[j + 1] = value;
+    }
+}
+
+static void sift_down(int *data, int root, int size) {
+    int value = data[root];
+    int child;
+    while ((child = 2 * root + 1) < size) {
+        if (child + 1 < size && data[child + 1] > data[child]) child++;
+        if (data[child] <= value) break;
+        data[root] = data[child];
+        root = child;
+    }
+    data[root] = value;
+}
+
+static void heap_sort(int *data, int size) {
+    for (int i = size / 2 - 1; i >= 0; i--) sift_down(data, i, size);
+    for (int end = size - 1; end > 0; end--) {
+        int temp = data[0];
+        data[0] = data[end];
+        data[end] = temp;
+        sift_down(data, 0, end);
+    }
+}
+
+static int median_of_three(int a, int b, int c) {
+    if (a < b) {
+        if (b < c) return b;
+        return a < c ? c : a;
+    }
+    if (a < c) return a;
+    return b < c ? c : b;
+}
+
+// Quicksort that falls back to heap sort once depth_limit is exhausted,
+// so adversarial inputs stay O(n log n)
+static void introsort_loop(int *data, int size, int depth_limit) {
+    while (size > INSERTION_SORT_MAX) {
+        if (depth_limit-- == 0) {
+            heap_sort(data, size);
+            return;
+        }
+        int pivot = median_of_three(data[0], data[size / 2], data[size - 1]);
+        int i = 0, j = size - 1;
+        while (i <= j) {
+            while (data[i] < pivot) i++;
+            while (data[j] > pivot) j--;
+            if (i <= j) {
+                int temp = data[i];
+                data[i] = data[j];
+                data[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        // Recurse into the smaller half, loop on the larger one
+        if (j + 1 < size - i) {
+            introsort_loop(data, j + 1, depth_limit);
+            data += i;
+            size -= i;
+        } else {
+            introsort_loop(data + i, size - i, depth_limit);
+            size = j + 1;
+        }
+    }
+    insertion_sort(data, size);
+}
+
+void introsort(int *data, int size) {
+    int depth_limit = 0;
+    for (int n = size; n > 1; n >>= 1) depth_limit += 2;
+    introsort_loop(data, size, depth_limit);
+}
+
+// Sorts data using tmp (same length) as scratch space. Signed ints are
+// ordered by flipping the sign bit so they compare as unsigned.
+void radix_sort(int *data, int *tmp, int size) {
+    if (size < RADIX_MIN_SIZE) {
+        introsort(data, size);
+        return;
+    }
+
+    // One counting pass builds the histograms for all four digits
+    static const int passes = 4;
+    size_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < size; i++) {
+        unsigned key = (unsigned)data[i] ^ 0x80000000u;
+        counts[0][key & 0xFF]++;
+        counts[1][(key >> 8) & 0xFF]++;
+        counts[2][(key >> 16) & 0xFF]++;
+        counts[3][key >> 24]++;
+    }
+
+    int *src = data;
+    int *dst = tmp;
+    for (int pass = 0; pass < passes; pass++) {
+        int shift = pass * 8;
+        // All keys share this digit: the pass would not move anything
+        if (counts[pass][((unsigned)src[0] ^ 0x80000000u) >> shift & 0xFF] == (size_t)size) continue;
+
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = counts[pass][d];
+            counts[pass][d] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < size; i++) {
+            unsigned key = (unsigned)src[i] ^ 0x80000000u;
+            dst[counts[pass][(key >> shift) & 0xFF]++] = src[i];
+        }
+        int *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != data) memcpy(data, src, size * sizeof(int));
+}
+
+static void merge_runs(const int *src, int *dst, int left, int mid, int right) {
+    int i = left, j = mid, k = left;
+    while (i < mid && j < right) {
+        dst[k++] = (src[j] < src[i]) ? src[j++] : src[i++];
+    }
+    while (i < mid) dst[k++] = src[i++];
+    while (j < right) dst[k++] = src[j++];
+}
+
+typedef struct {
+    int *src;
+    int *dst;
+    int left;
+    int mid;
+    int right;
+} SortTask;
+
+static void sort_slice_task(void *arg, int task) {
+    SortTask *t = (SortTask *)arg + task;
+    radix_sort(t->src + t->left, t->dst + t->left, t->right - t->left);
+}
+
+static void merge_task(void *arg, int task) {
+    SortTask *t = (SortTask *)arg + task;
+    merge_runs(t->src, t->dst, t->left, t->mid, t->right);
+}
+
+static void parallel_sort(int *data, int *tmp, int size, int slices) {
+    int bounds[MAX_POOL_THREADS + 1];
+    for (int i = 0; i <= slices; i++) {
+        bounds[i] = (int)((long long)size * i / slices);
+    }
+
+    SortTask tasks[MAX_POOL_THREADS];
+    for (int i = 0; i < slices; i++) {
+        tasks[i] = (SortTask){ data, tmp, bounds[i], bounds[i], bounds[i + 1] };
+    }
+    pool_run(sort_slice_task, tasks, slices);
+
+    // Merge neighbouring runs until one remains, ping-ponging buffers
+    int *src = data;
+    int *dst = tmp;
+    while (slices > 1) {
+        int merged = 0;
+        for (int i = 0; i + 1 < slices; i += 2) {
+            tasks[merged++] = (SortTask){ src, dst, bounds[i], bounds[i + 1], bounds[i + 2] };
+        }
+        if (slices % 2 == 1) {
+            int left = bounds[slices - 1];
+            memcpy(dst + left, src + left, (size - left) * sizeof(int));
+        }
+        pool_run(merge_task, tasks, merged);
+
+        int next = 0;
+        for (int i = 0; i <= slices; i += 2) bounds[next++] = bounds[i];
+        if (slices % 2 == 1) bounds[next++] = size;
+        slices = next - 1;
+
+        int *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != data) memcpy(data, src, size * sizeof(int));
+}
+
+// Sorts data ascending, picking the fastest strategy for the input size
+void sort_ints(int *data, int size) {
+    if (size < RADIX_MIN_SIZE) {
+        introsort(data, size);
+        return;
+    }
+
+    int *tmp = (int*)malloc(size * sizeof(int));
+    if (tmp == NULL) {
+        // Comparison sort needs no scratch buffer
+        introsort(data, size);
+        return;
+    }
+
+    int threads = pool_size();
+    if (size >= SORT_PARALLEL_MIN_SIZE && threads > 1) {
+        parallel_sort(data, tmp, size, threads);
+    } else {
+        radix_sort(data, tmp, size);
+    }
+    free(tmp);
+}
+
+void sort_dataset(int *data, int size) {
+    if (size < 2) { printf("Need at least 2 elements to sort.\n"); return; }
+    sort_ints(data, size);
+    if (data == dataset) {
+        data_sorted = 1;
+        index_invalidate();
+        journal_record(JOURNAL_SORT, NULL, 0);
+    }
+    printf("Dataset sorted in ascending order.\n");
+}
+
+// Positions matching cond: a contiguous range when sorted, the posting
+// list from the value index for point lookups, a parallel scan otherwise.
+// Returns the count or -1; *positions must be freed unless *first >= 0,
+// in which case the matches are the indices first .. first+count-1.
+static int lookup_positions(int *data, int size, const ValueCondition *cond,
+                            int *first, int **positions, const char **method) {
+    int is_global = (data == dataset && size == data_size);
+    *first = -1;
+
+    if (is_global && data_sorted) {
+        int lo = cond->a;
+        int hi = (cond->op == COND_BETWEEN) ? cond->b : cond->a;
+        *first = lower_bound(data, size, lo);
+        *method = "binary search";
+        return upper_bound(data, size, hi) - *first;
+    }
+
+    if (is_global && value_index.enabled && cond->op == COND_EQUAL) {
+        if (value_index.stale) index_build(data, size);
+        if (value_index.enabled) {
+            *method = "value index";
+            IndexEntry *e = index_find(cond->a);
+            int count = e ? e->count : 0;
+            *positions = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+            if (*positions == NULL) return -1;
+            if (count > 0) memcpy(*positions, entry_positions(e), count * sizeof(int));
+            return count;
+        }
+    }
+
+    *method = "full scan";
+    return find_matches(data, size, cond, positions);
+}
+
+void search_value(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    int choice;
+    ValueCondition cond = { COND_EQUAL, 0, 0 };
+    printf("Search by: 1. Value | 2. Range: ");
+    if (scanf("%d", &choice) != 1 || (choice != 1 && choice != 2)) {
+        printf("Invalid choice.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    if (choice == 1) {
+        printf("Enter value to search for: ");
+        if (scanf("%d", &cond.a) != 1) {
+            printf("Invalid input.\n");
+            while (getchar() != '\n');
+            return;
+        }
+    } else {
+        cond.op = COND_BETWEEN;
+        printf("Enter lowest and highest value: ");
+        if (scanf("%d %d", &cond.a, &cond.b) != 2 || cond.a > cond.b) {
+            printf("Invalid range.\n");
+            while (getchar() != '\n');
+            return;
+        }
+    }
+
+    int first;
+    int *positions = NULL;
+    const char *method;
+    int found_count = lookup_positions(data, size, &cond, &first, &positions, &method);
+    if (found_count < 0) {
+        printf("Error: Not enough memory to collect search results.\n");
+        return;
+    }
+
+    printf("--- Search Results (%s) ---\n", method);
+    for (int i = 0; i < found_count; i++) {
+        int index = (first >= 0) ? first + i : positions[i];
+        printf("Found %d at index %d\n", data[index], index);
+    }
+    free(positions);
+    if (found_count == 0) {
+        if (choice == 1) printf("Value %d not found in the dataset.\n", cond.a);
+        else printf("No values between %d and %d in the dataset.\n", cond.a, cond.b);
+    } else {
+        printf("Total occurrences: %d\n", found_count);
+    }
+}
+
+void toggle_value_index() {
+    if (value_index.enabled) {
+        index_clear();
+        value_index.enabled = 0;
+        printf("Value index disabled.\n");
+        return;
+    }
+    value_index.enabled = 1;
+    index_build(dataset, data_size);
+    if (value_index.enabled) {
+        printf("Value index enabled (%d distinct values).\n", value_index.live);
+    }
+}
+
+// Order Statistics
+// Exact quantiles use introselect on a scratch copy instead of a full sort;
+// on sorted data they are read off directly.
+
+// Partially orders a[lo..hi) so that a[k] holds the value it would have if
+// the range were sorted, with smaller values before it and larger after
+static void select_kth(int *a, int lo, int hi, int k) {
+    int budget = 0;
+    for (int n = hi - lo; n > 1; n >>= 1) budget += 2;
+
+    while (hi - lo > INSERTION_SORT_MAX) {
+        if (budget-- == 0) {
+            introsort(a + lo, hi - lo);
+            return;
+        }
+        int pivot = median_of_three(a[lo], a[lo + (hi - lo) / 2], a[hi - 1]);
+        int i = lo, j = hi - 1;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) {
+                int temp = a[i];
+                a[i] = a[j];
+                a[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) hi = j + 1;
+        else if (k >= i) lo = i;
+        else return;  // a[k] lies in the block equal to the pivot
+    }
+    insertion_sort(a + lo, hi - lo);
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentiles (0-100) by linear interpolation between the closest ranks.
+// Returns 0 if scratch memory could not be allocated.
+int exact_percentiles(int *data, int size, const double *percentiles, int count, double *out) {
+    int ranks[2 * MAX_PERCENTILES];
+    int num_ranks = 0;
+    for (int i = 0; i < count; i++) {
+        int lo = (int)((size - 1) * percentiles[i] / 100.0);
+        ranks[num_ranks++] = lo;
+        if (lo + 1 < size) ranks[num_ranks++] = lo + 1;
+    }
+
+    const int *sorted = data;
+    int *scratch = NULL;
+    if (!(data == dataset && data_sorted)) {
+        scratch = (int*)malloc(size * sizeof(int));
+        if (scratch == NULL) return 0;
+        memcpy(scratch, data, size * sizeof(int));
+
+        // Select ranks in ascending order: each selection leaves only larger
+        // values to its right, so the next one searches a smaller window
+        qsort(ranks, num_ranks, sizeof(int), compare_ints);
+        int window = 0;
+        for (int i = 0; i < num_ranks; i++) {
+            if (i > 0 && ranks[i] == ranks[i - 1]) continue;
+            select_kth(scratch, window, size, ranks[i]);
+            window = ranks[i] + 1;
+        }
+        sorted = scratch;
+    }
+
+    for (int i = 0; i < count; i++) {
+        double h = (size - 1) * percentiles[i] / 100.0;
+        int lo = (int)h;
+        double value = sorted[lo];
+        if (lo + 1 < size) value += (h - lo) * ((double)sorted[lo + 1] - sorted[lo]);
+        out[i] = value;
+    }
+    free(scratch);
+    return 1;
+}
+
+void compute_median(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    double fifty = 50.0, median;
+    if (!exact_percentiles(data, size, &fifty, 1, &median)) {
+        printf("Error: Not enough memory to compute the median.\n");
+        return;
+    }
+    printf("--- Result ---\nMedian: %.2f\n", median);
+}
+
+void compute_percentiles(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    char line[256];
+    printf("Enter up to %d percentiles (0-100) on one line [default: 50 95 99]: ", MAX_PERCENTILES);
+    while (getchar() != '\n');
+    if (fgets(line, sizeof(line), stdin) == NULL) return;
+
+    double percentiles[MAX_PERCENTILES];
+    int count = 0;
+    char *p = line, *end;
+    while (count < MAX_PERCENTILES) {
+        double value = strtod(p, &end);
+        if (end == p) break;
+        if (value < 0.0 || value > 100.0) {
+            printf("Invalid percentile %g. Must be between 0 and 100.\n", value);
+            return;
+        }
+        percentiles[count++] = value;
+        p = end;
+    }
+    if (count == 0) {
+        percentiles[0] = 50.0;
+        percentiles[1] = 95.0;
+        percentiles[2] = 99.0;
+        count = 3;
+    }
+
+    double results[MAX_PERCENTILES];
+    if (!exact_percentiles(data, size, percentiles, count, results)) {
+        printf("Error: Not enough memory to compute percentiles.\n");
+        return;
+    }
+    printf("--- Result ---\n");
+    for (int i = 0; i < count; i++) {
+        printf("p%-6g %.2f\n", percentiles[i], results[i]);
+    }
+}
+
+// Equal-width buckets spanning [min, max]
+void compute_histogram(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    int buckets;
+    printf("Enter number of buckets (1-%d): ", MAX_HISTOGRAM_BUCKETS);
+    if (scanf("%d", &buckets) != 1 || buckets < 1 || buckets > MAX_HISTOGRAM_BUCKETS) {
+        printf("Invalid bucket count.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    DataSummary summary;
+    summary_for(data, size, &summary);
+    long long span = (long long)summary.max - summary.min + 1;
+    long long width = (span + buckets - 1) / buckets;
+    // Rounding the width up can leave trailing buckets past the maximum
+    buckets = (int)((span + width - 1) / width);
+
+    int counts[MAX_HISTOGRAM_BUCKETS] = { 0 };
+    for (int i = 0; i < size; i++) {
+        counts[((long long)data[i] - summary.min) / width]++;
+    }
+
+    int largest = 0;
+    for (int b = 0; b < buckets; b++) {
+        if (counts[b] > largest) largest = counts[b];
+    }
+
+    printf("--- Histogram ---\n");
+    for (int b = 0; b < buckets; b++) {
+        long long lo = summary.min + b * width;
+        long long hi = lo + width - 1;
+        if (hi > summary.max) hi = summary.max;
+        int bar = (int)((long long)counts[b] * HISTOGRAM_BAR_WIDTH / largest);
+        printf("[%11lld, %11lld] %10d ", lo, hi, counts[b]);
+        for (int i = 0; i < bar; i++) putchar('#');
+        putchar('\n');
+    }
+}
+
+// Exact distinct count: counts runs in sorted order (sorting a copy first
+// unless the dataset is already sorted)
+void count_distinct(int *data, int size) {
+    if (size == 0) { printf("Dataset is empty.\n"); return; }
+    const int *sorted = data;
+    int *scratch = NULL;
+    if (!(data == dataset && data_sorted)) {
+        scratch = (int*)malloc(size * sizeof(int));
+        if (scratch == NULL) {
+            printf("Error: Not enough memory to count distinct values.\n");
+            return;
+        }
+        memcpy(scratch, data, size * sizeof(int));
+        sort_ints(scratch, size);
+        sorted = scratch;
+    }
+
+    int distinct = 1;
+    for (int i = 1; i < size; i++) distinct += (sorted[i] != sorted[i - 1]);
+    free(scratch);
+    printf("--- Result ---\nDistinct Values: %d\n", distinct);
+}
+
+// Streaming Sketches
+// Approximate quantiles and distinct counts in fixed memory, for batch mode
+// inputs that are never loaded. Both sketches merge losslessly, so inputs
+// processed separately combine into one answer.
+
+// Capacity of a level: the top level holds SKETCH_K items and each level
+// below holds 2/3 of the one above it, but never fewer than 2
+static int sketch_level_capacity(const QuantileSketch *s, int level) {
+    int capacity = SKETCH_K;
+    for (int depth = s->num_levels - 1 - level; depth > 0 && capacity > 2; depth--) {
+        capacity = (capacity * 2 + 2) / 3;
+    }
+    return capacity < 2 ? 2 : capacity;
+}
+
+static void sketch_update_capacity(QuantileSketch *s) {
+    s->total_capacity = 0;
+    for (int h = 0; h < s->num_levels; h++) s->total_capacity += sketch_level_capacity(s, h);
+}
+
+void sketch_init(QuantileSketch *s, unsigned long long seed) {
+    memset(s, 0, sizeof(*s));
+    s->num_levels = 1;
+    s->rng = seed * 2 + 1;
+    sketch_update_capacity(s);
+}
+
+void sketch_free(QuantileSketch *s) {
+    for (int h = 0; h < SKETCH_MAX_LEVELS; h++) free(s->levels[h]);
+    memset(s, 0, sizeof(*s));
+}
+
+static int sketch_push(QuantileSketch *s, int level, int value) {
+    if (s->sizes[level] == s->allocated[level]) {
+        int allocated = s->allocated[level] ? 2 * s->allocated[level] : 2 * SKETCH_K;
+        int *items = (int*)realloc(s->levels[level], allocated * sizeof(int));
+        if (items == NULL) return 0;
+        s->levels[level] = items;
+        s->allocated[level] = allocated;
+    }
+    s->levels[level][s->sizes[level]++] = value;
+    s->total_size++;
+    return 1;
+}
+
+// Compacts the lowest full level until the sketch fits its capacity
+static int sketch_compress(QuantileSketch *s) {
+    while (s->total_size > s->total_capacity) {
+        int h = 0;
+        while (s->sizes[h] < sketch_level_capacity(s, h)) h++;
+        if (h + 1 == s->num_levels) {
+            if (s->num_levels == SKETCH_MAX_LEVELS) return 1;
+            s->num_levels++;
+            sketch_update_capacity(s);
+        }
+
+        int *items = s->levels[h];
+        int size = s->sizes[h];
+        introsort(items, size);
+
+        // An odd item out stays behind; of the rest, a coin flip decides
+        // whether the even or odd positions are promoted
+        s->rng = s->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        int start = size % 2;
+        int offset = (int)(s->rng >> 63);
+        for (int i = start + offset; i < size; i += 2) {
+            if (!sketch_push(s, h + 1, items[i])) return 0;
+        }
+        s->sizes[h] = start;
+        s->total_size -= size - start;
+    }
+    return 1;
+}
+
+int sketch_add(QuantileSketch *s, const int *values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!sketch_push(s, 0, values[i])) return 0;
+        if (s->total_size > s->total_capacity && !sketch_compress(s)) return 0;
+        s->n++;
+    }
+    return 1;
+}
+
+// Folds src into dst; src is left unchanged
+int sketch_merge(QuantileSketch *dst, const QuantileSketch *src) {
+    if (src->num_levels > dst->num_levels) {
+        dst->num_levels = src->num_levels;
+        sketch_update_capacity(dst);
+    }
+    for (int h = 0; h < src->num_levels; h++) {
+        for (int i = 0; i < src->sizes[h]; i++) {
+            if (!sketch_push(dst, h, src->levels[h][i])) return 0;
+        }
+    }
+    dst->n += src->n;
+    return sketch_compress(dst);
+}
+
+typedef struct {
+    int value;
+    int level;
+} WeightedItem;
+
+static int compare_weighted(const void *a, const void *b) {
+    int x = ((const WeightedItem *)a)->value, y = ((const WeightedItem *)b)->value;
+    return (x > y) - (x < y);
+}
+
+// Approximate percentiles (0-100). Returns 0 if out of memory.
+int sketch_percentiles(const QuantileSketch *s, const double *percentiles, int count, int *out) {
+    WeightedItem *items = (WeightedItem*)malloc((s->total_size + 1) * sizeof(WeightedItem));
+    if (items == NULL) return 0;
+    int n = 0;
+    for (int h = 0; h < s->num_levels; h++) {
+        for (int i = 0; i < s->sizes[h]; i++) items[n++] = (WeightedItem){ s->levels[h][i], h };
+    }
+    qsort(items, n, sizeof(WeightedItem), compare_weighted);
+
+    for (int q = 0; q < count; q++) {
+        double target = percentiles[q] / 100.0 * s->n;
+        long long cumulative = 0;
+        int i = 0;
+        while (i < n - 1) {
+            cumulative += 1LL << items[i].level;
+            if (cumulative >= target) break;
+            i++;
+        }
+        out[q] = n > 0 ? items[i].value : 0;
+    }
+    free(items);
+    return 1;
+}
+
+static unsigned long long mix64(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
 
-// Function Pointer Definition
-typedef void (*OperationFunc)(int*, int);
+void hll_init(HyperLogLog *h) {
+    memset(h->registers, 0, sizeof(h->registers));
+}
 
+void hll_add(HyperLogLog *h, const int *values, int count) {
+    for (int i = 0; i < count; i++) {
+        unsigned long long hash = mix64((unsigned)values[i]);
+        unsigned index = (unsigned)(hash >> (64 - HLL_PRECISION));
+        // Position of the first set bit after the index bits; the guard
+        // bit caps it at 64 - HLL_PRECISION + 1
+        unsigned long long rest = (hash << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+        unsigned char rank = 1;
+        while (!(rest & (1ULL << 63))) {
+            rest <<= 1;
+            rank++;
+        }
+        if (rank > h->registers[index]) h->registers[index] = rank;
+    }
+}
 
-// Dynamic Memory Management Functions 
-void cleanup_memory() {
-    if (dataset != NULL) {
-        free(dataset);
-        dataset = NULL;
-        data_size = 0;
-        printf("\nDynamic memory freed.\n");
+void hll_merge(HyperLogLog *dst, const HyperLogLog *src) {
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        if (src->registers[i] > dst->registers[i]) dst->registers[i] = src->registers[i];
     }
 }
 
-void add_element() {
-    int value;
-    printf("Enter integer value to add: ");
-    if (scanf("%d", &value) != 1) {
-        printf("Invalid input.\n");
-        while (getchar() != '\n');
-        return;
+double hll_estimate(const HyperLogLog *h) {
+    const double m = HLL_REGISTERS;
+    double inverse_sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        inverse_sum += ldexp(1.0, -h->registers[i]);
+        zeros += (h->registers[i] == 0);
     }
-    
-    
-    data_size++;
-    int *temp = (int*)realloc(dataset, data_size * sizeof(int));
-    
-    if (temp == NULL) {
-        printf("Error: Failed to reallocate memory for new element.\n");
-        data_size--; 
-        return;
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / inverse_sum;
+    // Linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / zeros);
+    return estimate;
+}
+
+// Query Pipeline
+// Compound queries such as "filter x>0 | map x*2 | sum" run as one fused
+// pass over the data: each value flows through every stage before the next
+// is read, so no intermediate arrays are built.
+
+int is_even(long long value, void *ctx) {
+    (void)ctx;
+    return value % 2 == 0;
+}
+
+int is_odd(long long value, void *ctx) {
+    (void)ctx;
+    return value % 2 != 0;
+}
+
+void query_result_init(QueryResult *r) {
+    r->count = 0;
+    r->sum = 0;
+    r->min = LLONG_MAX;
+    r->max = LLONG_MIN;
+    r->overflow = 0;
+}
+
+void query_result_merge(QueryResult *into, const QueryResult *part) {
+    into->count += part->count;
+    if (part->overflow || __builtin_add_overflow(into->sum, part->sum, &into->sum)) into->overflow = 1;
+    if (part->min < into->min) into->min = part->min;
+    if (part->max > into->max) into->max = part->max;
+}
+
+// Applies a map stage to *v. Returns 0 if the result overflows.
+static int apply_map(const QueryStage *stage, long long *v) {
+    long long x = *v;
+    switch (stage->map) {
+        case MAP_ADD:      return !__builtin_add_overflow(x, stage->operand, v);
+        case MAP_SUBTRACT: return !__builtin_sub_overflow(x, stage->operand, v);
+        case MAP_MULTIPLY: return !__builtin_mul_overflow(x, stage->operand, v);
+        case MAP_DIVIDE:
+            if (x == LLONG_MIN && stage->operand == -1) return 0;
+            *v = x / stage->operand;
+            return 1;
+        case MAP_MODULO:
+            // LLONG_MIN % -1 traps on some targets although the result is 0
+            *v = stage->operand == -1 ? 0 : x % stage->operand;
+            return 1;
+        case MAP_NEGATE:   return !__builtin_sub_overflow(0LL, x, v);
+        case MAP_ABS:      return x >= 0 || !__builtin_sub_overflow(0LL, x, v);
+        case MAP_SQUARE:   return !__builtin_mul_overflow(x, x, v);
+    }
+    return 1;
+}
+
+// Runs the query's stages over a block, folding survivors into acc. Stops
+// at the first overflow, leaving acc->overflow set.
+void query_run_block(const Query *query, const int *data, int size, QueryResult *acc) {
+    if (acc->overflow) return;
+    // Only sum and avg read the running sum, so only they can overflow it
+    int needs_sum = query->aggregate == AGG_SUM || query->aggregate == AGG_AVG;
+    for (int i = 0; i < size; i++) {
+        long long v = data[i];
+        int keep = 1;
+        for (int s = 0; s < query->num_stages && keep; s++) {
+            const QueryStage *stage = &query->stages[s];
+            if (stage->kind == STAGE_MAP) {
+                if (!apply_map(stage, &v)) {
+                    acc->overflow = 1;
+                    return;
+                }
+            } else if (stage->pred != NULL) {
+                keep = stage->pred(v, stage->pred_ctx);
+            } else {
+                keep = condition_matches(&stage->cond, v);
+            }
+        }
+        if (!keep) continue;
+        acc->count++;
+        if (needs_sum && __builtin_add_overflow(acc->sum, v, &acc->sum)) {
+            acc->overflow = 1;
+            return;
+        }
+        if (v < acc->min) acc->min = v;
+        if (v > acc->max) acc->max = v;
     }
-    
-    dataset = temp;
-    dataset[data_size - 1] = value;
-    printf("Element %d added successfully. New size: %d\n", value, data_size);
 }
 
+typedef struct {
+    const Query *query;
+    const int *data;
+    int size;
+    int tasks;
+    QueryResult *parts;
+} QueryJob;
 
-void delete_element() {
-    if (data_size == 0) {
-        printf("Dataset is empty.\n");
+static void query_slice(void *arg, int task) {
+    QueryJob *job = (QueryJob *)arg;
+    int begin, end;
+    slice_bounds(job->size, job->tasks, task, &begin, &end);
+    query_result_init(&job->parts[task]);
+    query_run_block(job->query, job->data + begin, end - begin, &job->parts[task]);
+}
+
+// Runs query over data across the pool; partials merge in slice order
+void query_run(const Query *query, const int *data, int size, QueryResult *out) {
+    query_result_init(out);
+    int tasks = parallel_tasks(size);
+    QueryResult *parts = tasks > 1 ? (QueryResult*)malloc(tasks * sizeof(QueryResult)) : NULL;
+    if (parts == NULL) {
+        query_run_block(query, data, size, out);
         return;
     }
-    int index;
-    printf("Enter index (0 to %d) of element to delete: ", data_size - 1);
-    if (scanf("%d", &index) != 1 || index < 0 || index >= data_size) {
-        printf("Invalid index.\n");
-        while (getchar() != '\n');
-        return;
+
+    QueryJob job = { query, data, size, tasks, parts };
+    pool_run(query_slice, &job, tasks);
+    for (int i = 0; i < tasks; i++) query_result_merge(out, &parts[i]);
+    free(parts);
+}
+
+// Value of the query's aggregate: avg goes to *average, every other
+// aggregate to *value. Returns 0 if nothing passed the filters (min, max
+// and avg are then undefined) and -1 if the query overflowed.
+int query_value(const Query *query, const QueryResult *r, long long *value, double *average) {
+    if (r->overflow) return -1;
+    switch (query->aggregate) {
+        case AGG_SUM:   *value = r->sum; return 1;
+        case AGG_COUNT: *value = r->count; return 1;
+        case AGG_MIN:   *value = r->min; break;
+        case AGG_MAX:   *value = r->max; break;
+        case AGG_AVG:   *average = r->count ? (double)r->sum / r->count : 0.0; break;
     }
+    return r->count > 0;
+}
 
-    memmove(&dataset[index], &dataset[index + 1], (data_size - index - 1) * sizeof(int));
+static int parse_long_long(const char *text, long long *out) {
+    char *end;
+    if (*text == '\0') return 0;
+    *out = strtoll(text, &end, 10);
+    return *end == '\0';
+}
 
-    // Decrement size and shrink memory
-    data_size--;
-    int *temp = (int*)realloc(dataset, data_size * sizeof(int));
+static int parse_filter(char *expr, QueryStage *stage) {
+    static const struct { const char *op; ConditionOp cond; } comparisons[] = {
+        { "x>=", COND_GREATER_EQUAL }, { "x<=", COND_LESS_EQUAL },
+        { "x==", COND_EQUAL },         { "x!=", COND_NOT_EQUAL },
+        { "x>",  COND_GREATER },       { "x<",  COND_LESS }
+    };
+    stage->kind = STAGE_FILTER;
+    stage->pred = NULL;
+    stage->pred_ctx = NULL;
 
-    if (temp == NULL && data_size > 0) {
-        printf("Warning: Failed to shrink memory, but deletion successful.\n");
-    } else {
-        dataset = temp;
+    if (strcmp(expr, "even") == 0) { stage->pred = is_even; return 1; }
+    if (strcmp(expr, "odd") == 0) { stage->pred = is_odd; return 1; }
+
+    long long a, b;
+    char *dots = strstr(expr, "..");
+    if (dots != NULL) {
+        *dots = '\0';
+        if (!parse_long_long(expr, &a) || !parse_long_long(dots + 2, &b) || a > b ||
+            a < INT_MIN || b > INT_MAX) {
+            return 0;
+        }
+        stage->cond = (ValueCondition){ COND_BETWEEN, (int)a, (int)b };
+        return 1;
     }
-    printf("Element at index %d deleted. New size: %d\n", index, data_size);
-}
 
-// Function Pointers
-void compute_sum(int *data, int size) {
-    if (size == 0) { printf("Dataset is empty.\n"); return; }
-    long long sum = 0; // Use long long to prevent overflow
-    for (int i = 0; i < size; i++) {
-        sum += data[i];
+    for (size_t i = 0; i < sizeof(comparisons) / sizeof(comparisons[0]); i++) {
+        size_t len = strlen(comparisons[i].op);
+        if (strncmp(expr, comparisons[i].op, len) == 0) {
+            if (!parse_long_long(expr + len, &a) || a < INT_MIN || a > INT_MAX) return 0;
+            stage->cond = (ValueCondition){ comparisons[i].cond, (int)a, 0 };
+            return 1;
+        }
     }
-    printf("--- Result ---\nTotal Sum: %lld\n", sum);
+    return 0;
 }
 
-void compute_average(int *data, int size) {
-    if (size == 0) { printf("Dataset is empty.\n"); return; }
-    long long sum = 0;
-    for (int i = 0; i < size; i++) {
-        sum += data[i];
+static int parse_map(const char *expr, QueryStage *stage) {
+    static const struct { const char *op; MapOp map; } arithmetic[] = {
+        { "x+", MAP_ADD }, { "x-", MAP_SUBTRACT }, { "x*", MAP_MULTIPLY },
+        { "x/", MAP_DIVIDE }, { "x%", MAP_MODULO }
+    };
+    stage->kind = STAGE_MAP;
+    stage->operand = 0;
+
+    if (strcmp(expr, "-x") == 0 || strcmp(expr, "neg") == 0) { stage->map = MAP_NEGATE; return 1; }
+    if (strcmp(expr, "abs") == 0) { stage->map = MAP_ABS; return 1; }
+    if (strcmp(expr, "x*x") == 0 || strcmp(expr, "square") == 0) { stage->map = MAP_SQUARE; return 1; }
+
+    for (size_t i = 0; i < sizeof(arithmetic) / sizeof(arithmetic[0]); i++) {
+        if (strncmp(expr, arithmetic[i].op, 2) == 0) {
+            if (!parse_long_long(expr + 2, &stage->operand)) return 0;
+            stage->map = arithmetic[i].map;
+            return !((stage->map == MAP_DIVIDE || stage->map == MAP_MODULO) && stage->operand == 0);
+        }
     }
-    printf("--- Result ---\nAverage: %.2f\n", (float)sum / size);
+    return 0;
 }
 
-void find_min_max(int *data, int size) {
-    if (size == 0) { printf("Dataset is empty.\n"); return; }
-    int min = data[0];
-    int max = data[0];
-    for (int i = 1; i < size; i++) {
-        if (data[i] < min) min = data[i];
-        if (data[i] > max) max = data[i];
+// Strips a keyword and optional surrounding parentheses: "filter(x>0)" and
+// "filter x>0" (already without spaces) both yield "x>0"
+static char *stage_argument(char *stage, const char *keyword) {
+    size_t len = strlen(keyword);
+    if (strncmp(stage, keyword, len) != 0) return NULL;
+    char *arg = stage + len;
+    size_t arg_len = strlen(arg);
+    if (arg_len >= 2 && arg[0] == '(' && arg[arg_len - 1] == ')') {
+        arg[arg_len - 1] = '\0';
+        arg++;
     }
-    printf("--- Result ---\nMinimum Value: %d\nMaximum Value: %d\n", min, max);
+    return arg;
 }
 
-// Bubble Sort implementation
-void sort_dataset(int *data, int size) {
-    if (size < 2) { printf("Need at least 2 elements to sort.\n"); return; }
-    int swapped;
-    for (int i = 0; i < size - 1; i++) {
-        swapped = 0;
-        for (int j = 0; j < size - 1 - i; j++) {
-            if (data[j] > data[j+1]) {
-                int temp = data[j];
-                data[j] = data[j+1];
-                data[j+1] = temp;
-                swapped = 1;
-            }
+// Parses "stage | stage | ... | aggregate". Stages are "filter COND" with
+// COND one of x>N, x>=N, x<N, x<=N, x==N, x!=N, A..B, even, odd; and
+// "map EXPR" with EXPR one of x+N, x-N, x*N, x/N, x%N, -x, abs, x*x. The
+// aggregate is sum, count, min, max or avg. Returns 0 on a syntax error.
+int parse_query(const char *text, Query *query) {
+    static const struct { const char *name; QueryAggregate agg; } aggregates[] = {
+        { "sum", AGG_SUM }, { "count", AGG_COUNT }, { "min", AGG_MIN },
+        { "max", AGG_MAX }, { "avg", AGG_AVG }
+    };
+    char buffer[MAX_QUERY_LENGTH];
+    size_t n = 0;
+    for (const char *c = text; *c != '\0' && n + 1 < sizeof(buffer); c++) {
+        if (*c != ' ' && *c != '\t' && *c != '\n') buffer[n++] = *c;
+    }
+    buffer[n] = '\0';
+
+    query->num_stages = 0;
+    char *stages[MAX_QUERY_STAGES + 1];
+    int count = 0;
+    for (char *part = strtok(buffer, "|"); part != NULL; part = strtok(NULL, "|")) {
+        if (count == MAX_QUERY_STAGES + 1) return 0;
+        stages[count++] = part;
+    }
+    if (count == 0) return 0;
+
+    for (int i = 0; i < count - 1; i++) {
+        QueryStage *stage = &query->stages[query->num_stages++];
+        char *arg;
+        if ((arg = stage_argument(stages[i], "filter")) != NULL) {
+            if (!parse_filter(arg, stage)) return 0;
+        } else if ((arg = stage_argument(stages[i], "map")) != NULL) {
+            if (!parse_map(arg, stage)) return 0;
+        } else {
+            return 0;
         }
-        if (swapped == 0) break; 
     }
-    printf("Dataset sorted in ascending order.\n");
+
+    for (size_t i = 0; i < sizeof(aggregates) / sizeof(aggregates[0]); i++) {
+        if (strcmp(stages[count - 1], aggregates[i].name) == 0) {
+            query->aggregate = aggregates[i].agg;
+            return 1;
+        }
+    }
+    return 0;
 }
 
-void search_value(int *data, int size) {
-    if (size == 0) { printf("Dataset is empty.\n"); return; }
-    int target;
-    int found_count = 0;
-    printf("Enter value to search for: ");
-    if (scanf("%d", &target) != 1) {
-        printf("Invalid input.\n");
-        while (getchar() != '\n');
+void run_query(int *data, int size) {
+    char text[MAX_QUERY_LENGTH];
+    printf("Enter query (e.g. filter x>0 | map x*2 | sum): ");
+    while (getchar() != '\n');
+    if (fgets(text, sizeof(text), stdin) == NULL) return;
+
+    Query query;
+    if (!parse_query(text, &query)) {
+        printf("Invalid query. Stages: filter x>N|x<N|x==N|A..B|even|odd, map x+N|x*N|abs|...,\n");
+        printf("ending with sum, count, min, max or avg.\n");
         return;
     }
-    
-    printf("--- Search Results ---\n");
-    for (int i = 0; i < size; i++) {
-        if (data[i] == target) {
-            printf("Found %d at index %d\n", target, i);
-            found_count++;
-        }
-    }
-    if (found_count == 0) {
-        printf("Value %d not found in the dataset.\n", target);
+
+    QueryResult result;
+    long long value;
+    double average;
+    query_run(&query, data, size, &result);
+    printf("--- Query Result ---\n");
+    int found = query_value(&query, &result, &value, &average);
+    if (found < 0) {
+        printf("Value: (overflow: a result exceeded the range of a 64-bit integer)\n");
+        return;
+    } else if (found) {
+        if (query.aggregate == AGG_AVG) printf("Value: %.2f\n", average);
+        else printf("Value: %lld\n", value);
     } else {
-        printf("Total occurrences: %d\n", found_count);
+        printf("Value: (no values passed the filters)\n");
     }
+    printf("Values aggregated: %lld of %d\n", result.count, size);
 }
 
 // File I/O Functions
 
+static int host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe == 1;
+}
+
+static void put_u16(unsigned char *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_u32(unsigned char *p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = v >> (8 * i); }
+static void put_u64(unsigned char *p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = v >> (8 * i); }
+static uint16_t get_u16(const unsigned char *p) { return p[0] | (p[1] << 8); }
+static uint32_t get_u32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint32_t swap_u32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+}
+
+// Fletcher-64 over the values as little-endian 32-bit words. The modulo is
+// deferred for 64K words at a time, which cannot overflow the accumulators.
+uint64_t dataset_checksum(const int *data, int size) {
+    const uint64_t mod = 0xFFFFFFFFu;
+    uint64_t sum1 = 0, sum2 = 0;
+    int little_endian = host_is_little_endian();
+    for (int i = 0; i < size; ) {
+        int block_end = (size - i > 65536) ? i + 65536 : size;
+        for (; i < block_end; i++) {
+            uint32_t word = (uint32_t)data[i];
+            sum1 += little_endian ? word : swap_u32(word);
+            sum2 += sum1;
+        }
+        sum1 %= mod;
+        sum2 %= mod;
+    }
+    return (sum2 << 32) | sum1;
+}
+
+// Writes words as little-endian 32-bit values. Returns 0 on a write error.
+static int write_words(FILE *fp, const int *words, size_t count) {
+    if (host_is_little_endian()) return fwrite(words, sizeof(int), count, fp) == count;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t word = swap_u32((uint32_t)words[i]);
+        if (fwrite(&word, sizeof(word), 1, fp) != 1) return 0;
+    }
+    return 1;
+}
+
+// Writes the dataset to a temporary file and renames it over the old one,
+// so an interrupted save never leaves a half-written dataset behind. The
+// journal belonged to the previous snapshot and is removed.
+static int save_snapshot(void) {
+    FILE *fp = fopen(DATA_BIN_TEMP_FILENAME, "wb");
+    if (fp == NULL) {
+        perror("Error opening file for saving");
+        return 0;
+    }
+
+    uint64_t checksum = dataset_checksum(dataset, data_size);
+    unsigned char header[BIN_HEADER_SIZE] = { 0 };
+    memcpy(header, BIN_MAGIC, 4);
+    put_u16(header + 4, BIN_VERSION);
+    put_u16(header + 6, BIN_TYPE_INT32);
+    put_u32(header + 8, BIN_HEADER_SIZE);
+    put_u64(header + 16, (uint64_t)data_size);
+    put_u64(header + 24, checksum);
+
+    int ok = fwrite(header, 1, BIN_HEADER_SIZE, fp) == BIN_HEADER_SIZE;
+    ok = ok && write_words(fp, dataset, data_size);
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0) ok = 0;
+
+    if (!ok || rename(DATA_BIN_TEMP_FILENAME, DATA_BIN_FILENAME) != 0) {
+        perror("Error writing dataset file");
+        remove(DATA_BIN_TEMP_FILENAME);
+        return 0;
+    }
+    remove(DATA_JOURNAL_FILENAME);
+
+    snapshot_present = 1;
+    snapshot_count = (uint64_t)data_size;
+    snapshot_checksum = checksum;
+    journal_file_bytes = 0;
+    journal_clear_pending();
+    journal_needs_snapshot = 0;
+    printf("Dataset saved to %s.\n", DATA_BIN_FILENAME);
+    return 1;
+}
+
+// Writes the pending records after the journal's last valid record (which
+// also drops a torn tail left by an interrupted save) and syncs them. The
+// journal is created, bound to the current snapshot, if it does not exist.
+static int journal_append(void) {
+    FILE *fp = fopen(DATA_JOURNAL_FILENAME, journal_file_bytes > 0 ? "r+b" : "wb");
+    if (fp == NULL) return 0;
+
+    int ok;
+    if (journal_file_bytes > 0) {
+        ok = fseek(fp, journal_file_bytes, SEEK_SET) == 0;
+    } else {
+        unsigned char header[JOURNAL_HEADER_SIZE] = { 0 };
+        memcpy(header, JOURNAL_MAGIC, 4);
+        put_u16(header + 4, JOURNAL_VERSION);
+        put_u32(header + 8, JOURNAL_HEADER_SIZE);
+        put_u64(header + 16, snapshot_count);
+        put_u64(header + 24, snapshot_checksum);
+        ok = fwrite(header, 1, JOURNAL_HEADER_SIZE, fp) == JOURNAL_HEADER_SIZE;
+    }
+
+    for (size_t i = 0; ok && i < journal_pending_words; ) {
+        size_t words = 2 + (uint32_t)journal_pending[i + 1];
+        unsigned char checksum[8];
+        put_u64(checksum, dataset_checksum(journal_pending + i, (int)words));
+        ok = write_words(fp, journal_pending + i, words) && fwrite(checksum, 1, 8, fp) == 8;
+        i += words;
+    }
+
+    long length = ok ? ftell(fp) : -1;
+    ok = ok && length > 0 && fflush(fp) == 0 &&
+         ftruncate(fileno(fp), length) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) return 0;
+    journal_file_bytes = length;
+    return 1;
+}
+
+// Appends the changes since the last save to the journal, or writes a full
+// snapshot when there is none to extend or the journal has grown too large
 void save_results() {
-    if (data_size == 0) {
+    if (journal_unapplied) {
+        printf("Error: Not saving; %s holds changes that could not be applied.\n",
+               DATA_JOURNAL_FILENAME);
+        return;
+    }
+    if (!snapshot_present && data_size == 0) {
         printf("Dataset is empty. Nothing to save.\n");
         return;
     }
-    FILE *fp = fopen(DATA_FILENAME, "w");
-    if (fp == NULL) {
-        perror("Error opening file for saving");
+
+    if (snapshot_present && !journal_needs_snapshot) {
+        if (journal_pending_records == 0) {
+            printf("No changes since the last save.\n");
+            return;
+        }
+        long long journal_bytes = (journal_file_bytes > 0 ? journal_file_bytes : JOURNAL_HEADER_SIZE) +
+                                  (long long)journal_pending_words * sizeof(int) +
+                                  (long long)journal_pending_records * 8;
+        long long snapshot_bytes = BIN_HEADER_SIZE + (long long)snapshot_count * sizeof(int);
+        if (journal_bytes <= JOURNAL_MIN_COMPACT_BYTES || journal_bytes <= snapshot_bytes / 2) {
+            int records = journal_pending_records;
+            if (!journal_append()) {
+                perror("Error writing journal file");
+                return;
+            }
+            journal_clear_pending();
+            printf("Saved %d change%s to %s.\n", records, records == 1 ? "" : "s",
+                   DATA_JOURNAL_FILENAME);
+            return;
+        }
+    }
+    save_snapshot();
+}
+
+// Maps DATA_BIN_FILENAME copy-on-write and points dataset straight at the
+// payload, so no values are copied or parsed. Returns 1 if the file was
+// present (whether or not it loaded) and 0 if it does not exist.
+static int load_binary(void) {
+    int fd = open(DATA_BIN_FILENAME, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    unsigned char header[BIN_HEADER_SIZE];
+    if (fstat(fd, &st) != 0 || read(fd, header, BIN_HEADER_SIZE) != BIN_HEADER_SIZE) {
+        printf("File %s corrupted or empty.\n", DATA_BIN_FILENAME);
+        close(fd);
+        return 1;
+    }
+
+    uint32_t header_size = get_u32(header + 8);
+    uint64_t count = get_u64(header + 16);
+    uint64_t checksum = get_u64(header + 24);
+    if (memcmp(header, BIN_MAGIC, 4) != 0 || get_u16(header + 4) != BIN_VERSION ||
+        get_u16(header + 6) != BIN_TYPE_INT32 || header_size != BIN_HEADER_SIZE ||
+        count > INT_MAX || (uint64_t)st.st_size < header_size + count * sizeof(int)) {
+        printf("File %s has an unsupported or corrupted header.\n", DATA_BIN_FILENAME);
+        close(fd);
+        return 1;
+    }
+
+    cleanup_memory();
+    if (count == 0) {
+        close(fd);
+        snapshot_present = 1;
+        snapshot_count = 0;
+        snapshot_checksum = checksum;
+        printf("Successfully loaded 0 elements from %s.\n", DATA_BIN_FILENAME);
+        return 1;
+    }
+
+    size_t length = header_size + count * sizeof(int);
+    void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Error mapping dataset file");
+        return 1;
+    }
+
+    int *values = (int *)((unsigned char *)map + header_size);
+    if (!host_is_little_endian()) {
+        // Values must be byte swapped, so the zero-copy path is not possible
+        for (uint64_t i = 0; i < count; i++) values[i] = (int)swap_u32((uint32_t)values[i]);
+    }
+    if (dataset_checksum(values, (int)count) != checksum) {
+        printf("File %s failed its checksum. Starting with empty dataset.\n", DATA_BIN_FILENAME);
+        munmap(map, length);
+        return 1;
+    }
+
+    data_map = map;
+    data_map_length = length;
+    dataset = values;
+    data_size = (int)count;
+    data_capacity = (int)count;
+    snapshot_present = 1;
+    snapshot_count = count;
+    snapshot_checksum = checksum;
+    printf("Successfully loaded %d elements from %s.\n", data_size, DATA_BIN_FILENAME);
+    return 1;
+}
+
+static int journal_apply(uint32_t op, const int *operands, uint32_t count) {
+    switch (op) {
+        case JOURNAL_APPEND:
+            return dataset_append(operands, (int)count);
+        case JOURNAL_DELETE_RANGE:
+            return count == 2 && dataset_delete_range(operands[0], operands[1]) > 0;
+        case JOURNAL_DELETE_IF: {
+            if (count != 3 || operands[0] < COND_LESS || operands[0] > COND_OUTSIDE) return 0;
+            ValueCondition cond = { (ConditionOp)operands[0], operands[1], operands[2] };
+            dataset_delete_if(&cond);
+            return 1;
+        }
+        case JOURNAL_SORT:
+            if (count != 0) return 0;
+            sort_ints(dataset, data_size);
+            data_sorted = 1;
+            index_invalidate();
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Re-applies the journal on top of the snapshot just loaded. A journal
+// written for a different snapshot is ignored, and replay stops at the
+// first incomplete or corrupt record: that is where an interrupted save
+// stopped, and the next save overwrites it. A record that is intact but
+// cannot be applied keeps the whole file and disables saving instead.
+static void journal_replay(void) {
+    journal_file_bytes = 0;
+    FILE *fp = fopen(DATA_JOURNAL_FILENAME, "rb");
+    if (fp == NULL) return;
+
+    struct stat st;
+    unsigned char header[JOURNAL_HEADER_SIZE];
+    if (fstat(fileno(fp), &st) != 0 ||
+        fread(header, 1, JOURNAL_HEADER_SIZE, fp) != JOURNAL_HEADER_SIZE ||
+        memcmp(header, JOURNAL_MAGIC, 4) != 0 || get_u16(header + 4) != JOURNAL_VERSION ||
+        get_u32(header + 8) != JOURNAL_HEADER_SIZE ||
+        get_u64(header + 16) != snapshot_count || get_u64(header + 24) != snapshot_checksum) {
+        fclose(fp);
         return;
     }
-    
-    fprintf(fp, "DATA_SIZE=%d\n", data_size);
-    for (int i = 0; i < data_size; i++) {
-        fprintf(fp, "%d\n", dataset[i]);
+
+    long long offset = JOURNAL_HEADER_SIZE;
+    int records = 0;
+    int *words = NULL;
+    size_t capacity = 0;
+    unsigned char record_header[8], checksum[8];
+    journal_replaying = 1;
+    while (fread(record_header, 1, 8, fp) == 8) {
+        uint32_t op = get_u32(record_header);
+        uint32_t count = get_u32(record_header + 4);
+        if ((long long)count * (long long)sizeof(int) > (long long)st.st_size - offset - 16) break;
+        if (count + 2 > capacity) {
+            int *temp = (int*)realloc(words, (count + 2) * sizeof(int));
+            if (temp == NULL) {
+                journal_unapplied = 1;
+                break;
+            }
+            words = temp;
+            capacity = count + 2;
+        }
+        words[0] = (int)op;
+        words[1] = (int)count;
+        if (fread(words + 2, sizeof(int), count, fp) != count || fread(checksum, 1, 8, fp) != 8) break;
+        if (!host_is_little_endian()) {
+            for (uint32_t i = 0; i < count; i++) words[i + 2] = (int)swap_u32((uint32_t)words[i + 2]);
+        }
+        if (dataset_checksum(words, (int)count + 2) != get_u64(checksum)) break;
+        if (!journal_apply(op, words + 2, count)) {
+            journal_unapplied = 1;
+            break;
+        }
+        offset += 16 + (long long)count * sizeof(int);
+        records++;
     }
-    
+    journal_replaying = 0;
+    free(words);
     fclose(fp);
-    printf("Dataset saved to %s.\n", DATA_FILENAME);
+
+    journal_file_bytes = offset;
+    if (journal_unapplied) {
+        journal_file_bytes = st.st_size;
+        printf("Error: Could not apply every change in %s (out of memory?).\n", DATA_JOURNAL_FILENAME);
+        printf("The journal is kept and saving is disabled; reload once memory is available.\n");
+    } else if (records > 0) {
+        printf("Replayed %d change%s from %s.\n", records, records == 1 ? "" : "s",
+               DATA_JOURNAL_FILENAME);
+    }
 }
 
-void load_data() {
+// Legacy text format: a DATA_SIZE=N line followed by one value per line
+static void load_text(void) {
     FILE *fp = fopen(DATA_FILENAME, "r");
     if (fp == NULL) {
         printf("File %s not found. Starting with empty dataset.\n", DATA_FILENAME);
         return;
     }
-    
+
     // Read size from header
     int saved_size = 0;
     char line[64];
     if (fgets(line, sizeof(line), fp) && sscanf(line, "DATA_SIZE=%d", &saved_size) == 1 && saved_size >= 0) {
-        
-        cleanup_memory(); 
 
-        dataset = (int*)malloc(saved_size * sizeof(int));
-        if (dataset == NULL) {
+        cleanup_memory();
+
+        if (!dataset_reserve(saved_size)) {
             perror("Error allocating memory for loaded data");
             fclose(fp);
             return;
         }
 
-        int count = 0;
-        int value;
-        while (fgets(line, sizeof(line), fp) && count < saved_size) {
-            if (sscanf(line, "%d", &value) == 1) {
-                dataset[count++] = value;
-            }
+        // The reader skips the header line itself
+        rewind(fp);
+        if (dataset_append_stream(fp, NULL) < 0) {
+            printf("Error: Ran out of memory while loading %s.\n", DATA_FILENAME);
         }
-        data_size = count;
+        if (data_size > saved_size) data_size = saved_size;
         printf("Successfully loaded %d elements from %s.\n", data_size, DATA_FILENAME);
     } else {
         printf("File %s corrupted or empty.\n", DATA_FILENAME);
     }
-    
+
     fclose(fp);
 }
 
+// Prefers the binary file (plus its journal) and falls back to the text
+// format. Unsaved changes are discarded.
+void load_data() {
+    snapshot_present = 0;
+    journal_unapplied = 0;
+    if (load_binary()) {
+        if (snapshot_present) journal_replay();
+    } else {
+        load_text();
+    }
+    journal_clear_pending();
+    journal_needs_snapshot = 0;
+    dataset_replaced();
+}
+
+// Streaming Aggregation (Batch Mode)
+
+// Batch operations selectable with --ops
+#define BATCH_SUM      0x1
+#define BATCH_AVG      0x2
+#define BATCH_MINMAX   0x4
+#define BATCH_COUNT    0x8
+#define BATCH_DISTINCT 0x10
+#define BATCH_QUANTILE 0x20   // set by median and pNN entries
+#define MAX_BATCH_INPUTS 64
+
+typedef struct {
+    const char *name;
+    int flag;
+} BatchOp;
+
+BatchOp batch_ops[] = {
+    { "sum",      BATCH_SUM },
+    { "avg",      BATCH_AVG },
+    { "minmax",   BATCH_MINMAX },
+    { "count",    BATCH_COUNT },
+    { "distinct", BATCH_DISTINCT }
+};
+
+// What to compute, parsed from --ops and --query
+typedef struct {
+    int flags;
+    int num_percentiles;
+    double percentiles[MAX_PERCENTILES];
+    const char *percentile_names[MAX_PERCENTILES];
+    int has_query;
+    Query query;
+} BatchPlan;
+
+// Per-input results, merged in input order once every input is done
+typedef struct {
+    const char *path;
+    const BatchPlan *plan;
+    DataSummary summary;
+    QuantileSketch sketch;
+    HyperLogLog *hll;
+    QueryResult query_result;
+    long long skipped;
+    int failed;
+} BatchInput;
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s                                 (interactive menu)\n", prog);
+    fprintf(stderr, "       %s [--ops OPS] [--query QUERY] --input FILE [--input FILE ...]\n", prog);
+    fprintf(stderr, "OPS is a comma separated list of: sum, avg, minmax, count,\n");
+    fprintf(stderr, "  median, pNN (e.g. p95, p99.9) and distinct. Percentiles and distinct\n");
+    fprintf(stderr, "  are estimates (KLL sketch, HyperLogLog).\n");
+    fprintf(stderr, "QUERY is a pipeline such as \"filter x>0 | map x*2 | sum\", printed as query=.\n");
+    fprintf(stderr, "A query whose maps or sum overflow a 64-bit integer fails instead.\n");
+    fprintf(stderr, "FILE may be '-' for stdin. Values are streamed, never fully loaded.\n");
+}
+
+int parse_batch_ops(char *list, BatchPlan *plan) {
+    int num_ops = sizeof(batch_ops) / sizeof(batch_ops[0]);
+    plan->flags = 0;
+    plan->num_percentiles = 0;
+    for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int i = 0; i < num_ops; i++) {
+            if (strcmp(name, batch_ops[i].name) == 0) {
+                plan->flags |= batch_ops[i].flag;
+                found = 1;
+                break;
+            }
+        }
+
+        // median and pNN request a percentile
+        double percentile = -1.0;
+        char *end;
+        if (strcmp(name, "median") == 0) {
+            percentile = 50.0;
+        } else if (name[0] == 'p' && name[1] != '\0') {
+            percentile = strtod(name + 1, &end);
+            if (*end != '\0' || percentile < 0.0 || percentile > 100.0) percentile = -1.0;
+        }
+        if (!found && percentile >= 0.0) {
+            if (plan->num_percentiles == MAX_PERCENTILES) {
+                fprintf(stderr, "Error: at most %d percentiles per run.\n", MAX_PERCENTILES);
+                return 0;
+            }
+            plan->percentiles[plan->num_percentiles] = percentile;
+            plan->percentile_names[plan->num_percentiles++] = name;
+            plan->flags |= BATCH_QUANTILE;
+            found = 1;
+        }
+
+        if (!found) {
+            fprintf(stderr, "Error: unknown operation '%s'.\n", name);
+            return 0;
+        }
+    }
+    return plan->flags != 0;
+}
+
+// Pool task: streams one input through the requested accumulators
+static void stream_input(void *arg, int task) {
+    BatchInput *input = (BatchInput *)arg + task;
+    const BatchPlan *plan = input->plan;
+
+    FILE *fp = strcmp(input->path, "-") == 0 ? stdin : fopen(input->path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error opening input file %s: %s\n", input->path, strerror(errno));
+        input->failed = 1;
+        return;
+    }
+
+    IntReader reader;
+    int *chunk = (int*)malloc(STREAM_CHUNK_VALUES * sizeof(int));
+    if (chunk == NULL || !int_reader_open(&reader, fp)) {
+        fprintf(stderr, "Error allocating stream buffers for %s.\n", input->path);
+        free(chunk);
+        if (fp != stdin) fclose(fp);
+        input->failed = 1;
+        return;
+    }
+
+    int n;
+    while ((n = int_reader_fill(&reader, chunk, STREAM_CHUNK_VALUES)) > 0) {
+        summary_update(&input->summary, chunk, n);
+        if ((plan->flags & BATCH_QUANTILE) && !sketch_add(&input->sketch, chunk, n)) {
+            fprintf(stderr, "Error: out of memory in quantile sketch for %s.\n", input->path);
+            input->failed = 1;
+            break;
+        }
+        if (plan->flags & BATCH_DISTINCT) hll_add(input->hll, chunk, n);
+        if (plan->has_query) query_run_block(&plan->query, chunk, n, &input->query_result);
+    }
+    if (ferror(fp)) {
+        fprintf(stderr, "Error reading input file %s.\n", input->path);
+        input->failed = 1;
+    }
+    input->skipped = reader.skipped;
+
+    int_reader_close(&reader);
+    free(chunk);
+    if (fp != stdin) fclose(fp);
+}
+
+// Streams every input in fixed-size chunks, so memory use does not depend
+// on file size. Inputs run concurrently on the pool and their results are
+// merged in command line order. Results are printed as key=value lines.
+int run_batch(int argc, char *argv[]) {
+    char *ops_arg = NULL;
+    char *query_arg = NULL;
+    const char *paths[MAX_BATCH_INPUTS];
+    int num_inputs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            ops_arg = argv[++i];
+        } else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+            query_arg = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc && num_inputs < MAX_BATCH_INPUTS) {
+            paths[num_inputs++] = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((ops_arg == NULL && query_arg == NULL) || num_inputs == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    BatchPlan plan = { 0 };
+    if (ops_arg != NULL && !parse_batch_ops(ops_arg, &plan)) return EXIT_FAILURE;
+    if (query_arg != NULL) {
+        if (!parse_query(query_arg, &plan.query)) {
+            fprintf(stderr, "Error: invalid query '%s'.\n", query_arg);
+            return EXIT_FAILURE;
+        }
+        plan.has_query = 1;
+    }
+
+    BatchInput inputs[MAX_BATCH_INPUTS];
+    for (int i = 0; i < num_inputs; i++) {
+        BatchInput *input = &inputs[i];
+        input->path = paths[i];
+        input->plan = &plan;
+        input->skipped = 0;
+        input->failed = 0;
+        summary_init(&input->summary);
+        query_result_init(&input->query_result);
+        sketch_init(&input->sketch, (unsigned long long)i);
+        input->hll = NULL;
+        if (plan.flags & BATCH_DISTINCT) {
+            input->hll = (HyperLogLog*)malloc(sizeof(HyperLogLog));
+            if (input->hll == NULL) {
+                perror("Error allocating distinct counter");
+                return EXIT_FAILURE;
+            }
+            hll_init(input->hll);
+        }
+    }
+    pool_run(stream_input, inputs, num_inputs);
+
+    // Merge in input order so the output never depends on scheduling
+    int status = EXIT_SUCCESS;
+    long long skipped = 0;
+    BatchInput *total = &inputs[0];
+    for (int i = 0; i < num_inputs; i++) {
+        if (inputs[i].failed) status = EXIT_FAILURE;
+        skipped += inputs[i].skipped;
+        if (i == 0) continue;
+        summary_merge(&total->summary, &inputs[i].summary);
+        if ((plan.flags & BATCH_QUANTILE) && !sketch_merge(&total->sketch, &inputs[i].sketch)) {
+            fprintf(stderr, "Error: out of memory merging quantile sketches.\n");
+            status = EXIT_FAILURE;
+        }
+        if (plan.flags & BATCH_DISTINCT) hll_merge(total->hll, inputs[i].hll);
+        query_result_merge(&total->query_result, &inputs[i].query_result);
+    }
+
+    if (status == EXIT_SUCCESS) {
+        DataSummary *summary = &total->summary;
+        if (plan.flags & BATCH_COUNT) printf("count=%lld\n", summary->count);
+        if (plan.flags & BATCH_SUM) printf("sum=%lld\n", summary->sum);
+        if (summary->count == 0) {
+            if (plan.flags & ~(BATCH_COUNT | BATCH_SUM)) fprintf(stderr, "Input contains no values.\n");
+        } else {
+            if (plan.flags & BATCH_AVG) printf("avg=%.2f\n", (double)summary->sum / summary->count);
+            if (plan.flags & BATCH_MINMAX) printf("min=%d\nmax=%d\n", summary->min, summary->max);
+            if (plan.flags & BATCH_QUANTILE) {
+                int results[MAX_PERCENTILES];
+                if (sketch_percentiles(&total->sketch, plan.percentiles, plan.num_percentiles, results)) {
+                    for (int i = 0; i < plan.num_percentiles; i++) {
+                        // The sketch may miss the extremes; the summary has them exactly
+                        if (plan.percentiles[i] == 0.0) results[i] = summary->min;
+                        if (plan.percentiles[i] == 100.0) results[i] = summary->max;
+                        printf("%s=%d\n", plan.percentile_names[i], results[i]);
+                    }
+                } else {
+                    fprintf(stderr, "Error: out of memory querying quantile sketch.\n");
+                    status = EXIT_FAILURE;
+                }
+            }
+            if (plan.flags & BATCH_DISTINCT) printf("distinct=%.0f\n", hll_estimate(total->hll));
+        }
+        if (plan.has_query) {
+            long long value;
+            double average;
+            int found = query_value(&plan.query, &total->query_result, &value, &average);
+            if (found < 0) {
+                fprintf(stderr, "Error: query overflowed a 64-bit integer.\n");
+                status = EXIT_FAILURE;
+            } else if (!found) {
+                fprintf(stderr, "No values passed the query filters.\n");
+            } else if (plan.query.aggregate == AGG_AVG) {
+                printf("query=%.2f\n", average);
+            } else {
+                printf("query=%lld\n", value);
+            }
+        }
+        if (skipped > 0) {
+            fprintf(stderr, "Warning: skipped %lld invalid tokens.\n", skipped);
+        }
+    }
+
+    for (int i = 0; i < num_inputs; i++) {
+        sketch_free(&inputs[i].sketch);
+        free(inputs[i].hll);
+    }
+    pool_shutdown();
+    return status;
+}
+
 // Menu & Main Function
 
 void view_dataset() {
@@ -228,12 +3077,22 @@ void display_menu() {
     printf("  1. Add Element\n");
     printf("  2. Delete Element (by index)\n");
     printf("  3. View Dataset\n");
+    printf(" 11. Bulk Append (file or typed values)\n");
+    printf(" 12. Delete Index Range\n");
+    printf(" 13. Delete Values by Condition\n");
+    printf(" 14. Toggle Value Index (fast repeated searches)\n");
     printf("-- Dynamic Operations --\n");
     printf("  4. Compute Sum\n");
     printf("  5. Compute Average\n");
     printf("  6. Find Min/Max\n");
     printf("  7. Sort Dataset (Ascending)\n");
     printf("  8. Search Value\n");
+    printf("-- Order Statistics --\n");
+    printf(" 15. Median\n");
+    printf(" 16. Percentiles (e.g. p50/p95/p99)\n");
+    printf(" 17. Histogram\n");
+    printf(" 18. Count Distinct Values\n");
+    printf(" 19. Run Query (filter | map | aggregate)\n");
     printf("-- Persistence --\n");
     printf("  9. Save Results to File\n");
     printf(" 10. Load Data from File\n");
@@ -247,10 +3106,30 @@ OperationFunc math_operations[] = {
     compute_average,   
     find_min_max,      
     sort_dataset,   
-    search_value       
+    search_value,
+    compute_median,
+    compute_percentiles,
+    compute_histogram,
+    count_distinct,
+    run_query
 };
 
-int main() {
+// Menu choices 4-8 map to the first five operations, 15-19 to the rest.
+// Returns -1 if the choice is not an operation.
+int operation_for_choice(int choice) {
+    if (choice >= 4 && choice <= 8) return choice - 4;
+    if (choice >= 15 && choice <= 19) return choice - 15 + 5;
+    return -1;
+}
+
+// math_engine_bench.c includes this file with MATH_ENGINE_NO_MAIN defined
+#ifndef MATH_ENGINE_NO_MAIN
+int main(int argc, char *argv[]) {
+    // Any command line arguments select the non-interactive batch mode
+    if (argc > 1) {
+        return run_batch(argc, argv);
+    }
+
     load_data(); 
 
     int choice;
@@ -263,8 +3142,8 @@ int main() {
         }
         
         // Dispatch logic
-        if (choice >= 4 && choice <= 8) {
-            int operation_index = choice - 4; 
+        int operation_index = operation_for_choice(choice);
+        if (operation_index >= 0) {
             math_operations[operation_index](dataset, data_size);
         } else {
             switch (choice) {
@@ -273,6 +3152,10 @@ int main() {
                 case 3: view_dataset(); break;
                 case 9: save_results(); break;
                 case 10: load_data(); break;
+                case 11: bulk_append(); break;
+                case 12: delete_range(); break;
+                case 13: delete_by_condition(); break;
+                case 14: toggle_value_index(); break;
                 case 0: break;
                 default: printf("Invalid choice. Try again.\n");
             }
@@ -280,5 +3163,8 @@ int main() {
     } while (choice != 0);
 
     cleanup_memory();
+    index_clear();
+    pool_shutdown();
     return 0;
 }
+#endif
@@ -0,0 +1,304 @@
+#define MATH_ENGINE_NO_MAIN
+#include "math_engine.c"
+
+#include <time.h>
+#include <sys/resource.h>
+
+// Benchmark Settings
+#define BENCH_MIN_SIZE 1000LL
+#define BENCH_DEFAULT_MAX_SIZE 10000000LL
+#define BENCH_MIN_SECONDS 0.2
+#define BENCH_MAX_REPS 1000
+#define BENCH_SEED 0x9E3779B97F4A7C15ULL
+
+// Operations that read stdin get their answers from a script file
+typedef struct {
+    const char *name;
+    OperationFunc func;
+    const char *script;   // stdin contents, NULL if the operation reads none
+    int mutates;          // needs a fresh copy of the input every repetition
+} BenchCase;
+
+BenchCase bench_cases[] = {
+    { "sum",         compute_sum,         NULL,             0 },
+    { "average",     compute_average,     NULL,             0 },
+    { "min_max",     find_min_max,        NULL,             0 },
+    { "sort",        sort_dataset,        NULL,             1 },
+    { "search",      search_value,        "1\n12345\n",     0 },
+    { "median",      compute_median,      NULL,             0 },
+    { "percentiles", compute_percentiles, "\n50 95 99\n",   0 },
+    { "histogram",   compute_histogram,   "20\n",           0 },
+    { "distinct",    count_distinct,      NULL,             0 },
+    { "query",       run_query,           "\nfilter x>0 | map x*2 | sum\n", 0 }
+};
+
+typedef struct {
+    int reps;
+    double best;   // seconds
+    double total;  // seconds
+} Timing;
+
+const char *script_path = NULL;
+int saved_stdout = -1;
+
+double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+long peak_rss_kb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+    return usage.ru_maxrss;
+}
+
+// Engine operations print their results; hide that while timing
+void silence_stdout() {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+}
+
+void restore_stdout() {
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+// Points stdin at a file holding script, so prompts are answered
+int feed_stdin(const char *script) {
+    FILE *fp = fopen(script_path, "w");
+    if (fp == NULL) return 0;
+    fputs(script, fp);
+    fclose(fp);
+    return freopen(script_path, "r", stdin) != NULL;
+}
+
+void fill_random(int *data, long long size, unsigned long long seed) {
+    unsigned long long state = seed;
+    for (long long i = 0; i < size; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        data[i] = (int)(state >> 32);
+    }
+}
+
+void report(const char *name, long long size, const Timing *t) {
+    double best_ns = t->best * 1e9 / size;
+    double mean_ns = t->total * 1e9 / t->reps / size;
+    printf("%s,%lld,%d,%.3f,%.3f,%.2f,%ld\n", name, size, t->reps,
+           best_ns, mean_ns, size / t->best / 1e6, peak_rss_kb());
+    fflush(stdout);
+}
+
+// Repeats the case until BENCH_MIN_SECONDS have passed
+void bench_operation(const BenchCase *c, const int *input, int *work, int size) {
+    Timing t = { 0, 1e30, 0.0 };
+    memcpy(work, input, size * sizeof(int));
+    while (t.reps < BENCH_MAX_REPS && (t.reps == 0 || t.total < BENCH_MIN_SECONDS)) {
+        if (c->mutates && t.reps > 0) memcpy(work, input, size * sizeof(int));
+        if (c->script != NULL && !feed_stdin(c->script)) {
+            fprintf(stderr, "Error: could not prepare input for %s.\n", c->name);
+            return;
+        }
+
+        silence_stdout();
+        double start = now_seconds();
+        c->func(work, size);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+
+        t.reps++;
+        t.total += elapsed;
+        if (elapsed < t.best) t.best = elapsed;
+    }
+    report(c->name, size, &t);
+}
+
+// Times one reduction kernel variant directly, bypassing the pool
+void bench_kernel(const char *name, ReduceKernel kernel, const int *input, int size) {
+    Timing t = { 0, 1e30, 0.0 };
+    DataSummary summary;
+    while (t.reps < BENCH_MAX_REPS && (t.reps == 0 || t.total < BENCH_MIN_SECONDS)) {
+        double start = now_seconds();
+        kernel(input, size, &summary);
+        double elapsed = now_seconds() - start;
+        t.reps++;
+        t.total += elapsed;
+        if (elapsed < t.best) t.best = elapsed;
+    }
+    report(name, size, &t);
+}
+
+// Snapshot save, journal save, binary load (mmap + checksum) and legacy
+// text load through the engine's own persistence functions, run in the
+// current directory
+void bench_persistence(const int *input, int size) {
+    Timing save = { 0, 1e30, 0.0 }, load = { 0, 1e30, 0.0 };
+    while (save.reps < BENCH_MAX_REPS && (save.reps == 0 || save.total + load.total < BENCH_MIN_SECONDS)) {
+        silence_stdout();
+        cleanup_memory();
+        dataset_append(input, size);
+        if (data_size != size) {
+            restore_stdout();
+            fprintf(stderr, "Error: could not prepare a dataset of %d elements for save.\n", size);
+            return;
+        }
+
+        double start = now_seconds();
+        save_results();
+        double mid = now_seconds();
+        load_data();
+        // Touch every page so lazy mapping is not mistaken for a free load
+        DataSummary summary;
+        summarize(dataset, data_size, &summary);
+        double end = now_seconds();
+        restore_stdout();
+
+        save.reps++;
+        save.total += mid - start;
+        if (mid - start < save.best) save.best = mid - start;
+        load.reps++;
+        load.total += end - mid;
+        if (end - mid < load.best) load.best = end - mid;
+    }
+    report("save", size, &save);
+    report("load_binary", size, &load);
+
+    // Saving a single added value only appends to the journal
+    Timing journal = { 0, 1e30, 0.0 };
+    while (journal.reps < BENCH_MAX_REPS && (journal.reps == 0 || journal.total < BENCH_MIN_SECONDS)) {
+        int value = input[journal.reps % size];
+        silence_stdout();
+        double start = now_seconds();
+        dataset_append(&value, 1);
+        save_results();
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        journal.reps++;
+        journal.total += elapsed;
+        if (elapsed < journal.best) journal.best = elapsed;
+    }
+    report("save_journal", size, &journal);
+    remove(DATA_BIN_FILENAME);
+    remove(DATA_JOURNAL_FILENAME);
+
+    // Legacy text format, written once
+    FILE *fp = fopen(DATA_FILENAME, "w");
+    if (fp == NULL) return;
+    fprintf(fp, "DATA_SIZE=%d\n", size);
+    for (int i = 0; i < size; i++) fprintf(fp, "%d\n", input[i]);
+    fclose(fp);
+
+    Timing text = { 0, 1e30, 0.0 };
+    while (text.reps < BENCH_MAX_REPS && (text.reps == 0 || text.total < BENCH_MIN_SECONDS)) {
+        silence_stdout();
+        double start = now_seconds();
+        load_data();
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        text.reps++;
+        text.total += elapsed;
+        if (elapsed < text.best) text.best = elapsed;
+    }
+    report("load_text", size, &text);
+    remove(DATA_FILENAME);
+
+    silence_stdout();
+    cleanup_memory();
+    restore_stdout();
+}
+
+void bench_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--max N] [--only NAME]\n", prog);
+    fprintf(stderr, "Runs every operation on random datasets of 1e3, 1e4, ... up to N\n");
+    fprintf(stderr, "elements (default 1e7, at most 1e9) and prints CSV to stdout.\n");
+}
+
+int main(int argc, char *argv[]) {
+    long long max_size = BENCH_DEFAULT_MAX_SIZE;
+    const char *only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_size = (long long)strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (max_size < BENCH_MIN_SIZE || max_size > 1000000000LL) {
+        bench_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Persistence benchmarks write dataset files: keep them out of the way
+    char work_dir[] = "/tmp/math_engine_bench.XXXXXX";
+    char script_file[sizeof(work_dir) + 16];
+    if (mkdtemp(work_dir) == NULL || chdir(work_dir) != 0) {
+        perror("Error creating benchmark directory");
+        return EXIT_FAILURE;
+    }
+    snprintf(script_file, sizeof(script_file), "%s/stdin", work_dir);
+    script_path = script_file;
+
+    select_reduce_kernel();
+    fprintf(stderr, "Kernel: %s, threads: %d, work dir: %s\n",
+            reduce_kernel_name, pool_size(), work_dir);
+    printf("op,n,reps,best_ns_per_elem,mean_ns_per_elem,best_melem_per_s,peak_rss_kb\n");
+
+    KernelChoice kernels[] = {
+        { "kernel_scalar", reduce_scalar },
+#ifdef HAVE_X86_SIMD
+        { "kernel_sse2",   reduce_sse2 },
+        { "kernel_avx2",   reduce_avx2 },
+        { "kernel_avx512", reduce_avx512 },
+#endif
+    };
+    int num_kernels = sizeof(kernels) / sizeof(kernels[0]);
+    int num_cases = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+    for (long long size = BENCH_MIN_SIZE; size <= max_size; size *= 10) {
+        int *input = (int*)malloc(size * sizeof(int));
+        int *work = (int*)malloc(size * sizeof(int));
+        if (input == NULL || work == NULL) {
+            fprintf(stderr, "Skipping n=%lld: not enough memory.\n", size);
+            free(input);
+            free(work);
+            break;
+        }
+        fill_random(input, size, BENCH_SEED);
+
+        for (int k = 0; k < num_kernels; k++) {
+            // Kernel names carry a "kernel_" prefix over the dispatch name
+            if (!kernel_supported(kernels[k].name + 7)) continue;
+            if (only != NULL && strcmp(only, kernels[k].name) != 0) continue;
+            bench_kernel(kernels[k].name, kernels[k].kernel, input, (int)size);
+        }
+        for (int c = 0; c < num_cases; c++) {
+            if (only != NULL && strcmp(only, bench_cases[c].name) != 0) continue;
+            bench_operation(&bench_cases[c], input, work, (int)size);
+        }
+        if (only == NULL || strncmp(only, "load", 4) == 0 || strcmp(only, "save") == 0) {
+            bench_persistence(input, (int)size);
+        }
+
+        free(input);
+        free(work);
+    }
+
+    remove(script_path);
+    if (chdir("/") == 0) rmdir(work_dir);
+    pool_shutdown();
+    return EXIT_SUCCESS;
+}
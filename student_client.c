@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Load generator for "student_system serve SOCKET". Each client thread
+// keeps one request in flight on its own connection and prints, per
+// request type, CSV of throughput and latency percentiles.
+
+// Load Settings
+#define LOAD_DEFAULT_CLIENTS 8
+#define LOAD_DEFAULT_SECONDS 5.0
+#define LOAD_DEFAULT_WRITES 10     // percent of requests
+#define LOAD_DEFAULT_IDS 100000    // GET and UPDATE pick ids from 1 to this
+#define LOAD_MAX_CLIENTS 256
+#define LOAD_LINE_SIZE 512
+#define LOAD_SUB_BUCKETS 32        // latency histogram: 32 buckets per power of two
+#define LOAD_BUCKETS (64 * LOAD_SUB_BUCKETS)
+#define LOAD_ADD_BASE 1000000000   // ids of added students: base + client * span
+#define LOAD_ADD_SPAN 10000000
+
+typedef enum {
+    LOAD_GET,
+    LOAD_FIND,
+    LOAD_REPORT,
+    LOAD_ADD,
+    LOAD_UPDATE,
+    LOAD_DELETE,
+    LOAD_TYPES
+} LoadType;
+
+const char *load_names[LOAD_TYPES] = { "get", "find", "report", "add", "update", "delete" };
+
+// Latencies in nanoseconds fall in buckets at most 1/LOAD_SUB_BUCKETS
+// wide relative to their value
+typedef struct {
+    long requests;
+    long errors;
+    long buckets[LOAD_BUCKETS];
+} LoadStats;
+
+typedef struct {
+    int index;
+    unsigned long long state;   // xorshift
+    int added;                  // students this client added and has not deleted
+    int failed;
+    LoadStats stats[LOAD_TYPES];
+} LoadClient;
+
+const char *socket_path = NULL;
+int writes_percent = LOAD_DEFAULT_WRITES;
+int id_range = LOAD_DEFAULT_IDS;
+double deadline = 0;
+
+double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+unsigned int next_random(LoadClient *c) {
+    c->state ^= c->state << 13;
+    c->state ^= c->state >> 7;
+    c->state ^= c->state << 17;
+    return (unsigned int)(c->state >> 32);
+}
+
+int connect_server() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int bucket_of(uint64_t ns) {
+    if (ns < LOAD_SUB_BUCKETS) return (int)ns;
+    int exponent = 63 - __builtin_clzll(ns);
+    int mantissa = (int)(ns >> (exponent - 5)) & (LOAD_SUB_BUCKETS - 1);
+    return (exponent - 4) * LOAD_SUB_BUCKETS + mantissa;
+}
+
+// Smallest latency in bucket, in nanoseconds
+double bucket_floor(int bucket) {
+    if (bucket < LOAD_SUB_BUCKETS) return bucket;
+    int exponent = bucket / LOAD_SUB_BUCKETS + 4;
+    return (double)(LOAD_SUB_BUCKETS + bucket % LOAD_SUB_BUCKETS) * (double)(1ULL << (exponent - 5));
+}
+
+// Writes the next request for client c into line. Reads are mostly GETs
+// with some name searches and the odd report; writes are half updates,
+// the rest adds and deletes of the client's own students.
+LoadType make_request(LoadClient *c, char *line, size_t size) {
+    unsigned int roll = next_random(c) % 100;
+    int id = 1 + (int)(next_random(c) % id_range);
+    float grade = (next_random(c) % 41) / 10.0f;
+    if (roll >= (unsigned int)writes_percent) {
+        roll = next_random(c) % 100;
+        if (roll < 90) {
+            snprintf(line, size, "GET %d\n", id);
+            return LOAD_GET;
+        }
+        if (roll < 99) {
+            snprintf(line, size, "FIND %03d\n", id % 1000);
+            return LOAD_FIND;
+        }
+        snprintf(line, size, "REPORT\n");
+        return LOAD_REPORT;
+    }
+
+    roll = next_random(c) % 100;
+    if (roll < 50) {
+        snprintf(line, size, "UPDATE %d,Student %d,%d,Course %d,%.1f,%.1f,%.1f\n",
+                 id, id, 18 + id % 60, id % 200, grade, grade, grade);
+        return LOAD_UPDATE;
+    }
+    int own = LOAD_ADD_BASE + c->index * LOAD_ADD_SPAN;
+    if (roll < 75 || c->added == 0) {
+        int added = own + c->added++;
+        snprintf(line, size, "ADD %d,Load %d,20,Load Course,%.1f,%.1f,%.1f\n", added, added, grade, grade, grade);
+        return LOAD_ADD;
+    }
+    snprintf(line, size, "DELETE %d\n", own + --c->added);
+    return LOAD_DELETE;
+}
+
+// Client thread body: sends requests until the deadline
+void *run_client(void *arg) {
+    LoadClient *c = (LoadClient *)arg;
+    int fd = connect_server();
+    FILE *in = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (in == NULL) {
+        if (fd >= 0) close(fd);
+        c->failed = 1;
+        return NULL;
+    }
+
+    char line[LOAD_LINE_SIZE];
+    while (now_seconds() < deadline) {
+        LoadType type = make_request(c, line, sizeof(line));
+        size_t length = strlen(line);
+        double start = now_seconds();
+        if (write(fd, line, length) != (ssize_t)length || fgets(line, sizeof(line), in) == NULL) {
+            c->failed = 1;
+            break;
+        }
+        int lines = 0;
+        if (strncmp(line, "OK ", 3) == 0) {
+            lines = atoi(line + 3);
+            for (int i = 0; i < lines; i++) {
+                // Result lines may be longer than line; read to each newline
+                int ch;
+                while ((ch = getc(in)) != EOF && ch != '\n') {
+                }
+            }
+        }
+        double elapsed = now_seconds() - start;
+
+        LoadStats *stats = &c->stats[type];
+        stats->requests++;
+        if (line[0] != 'O') stats->errors++;
+        stats->buckets[bucket_of((uint64_t)(elapsed * 1e9))]++;
+    }
+    fclose(in);
+    return NULL;
+}
+
+// Percentile p of the latencies in stats, in microseconds
+double percentile_us(const LoadStats *stats, double p) {
+    long rank = (long)(p / 100 * stats->requests), seen = 0;
+    for (int b = 0; b < LOAD_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen > rank) return bucket_floor(b) / 1e3;
+    }
+    return 0;
+}
+
+void report(const char *name, const LoadStats *stats, double seconds) {
+    printf("%s,%ld,%ld,%.0f,%.1f,%.1f,%.1f\n", name, stats->requests, stats->errors,
+           stats->requests / seconds, percentile_us(stats, 50), percentile_us(stats, 99),
+           percentile_us(stats, 99.9));
+}
+
+void load_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s SOCKET [--clients N] [--seconds S] [--writes PERCENT] [--ids N]\n", prog);
+    fprintf(stderr, "Drives a student_system server with N connections for S seconds and\n");
+    fprintf(stderr, "prints CSV of requests per second and latency per request type.\n");
+}
+
+int main(int argc, char *argv[]) {
+    int clients = LOAD_DEFAULT_CLIENTS;
+    double seconds = LOAD_DEFAULT_SECONDS;
+    if (argc < 2) {
+        load_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    socket_path = argv[1];
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--writes") == 0 && i + 1 < argc) {
+            writes_percent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ids") == 0 && i + 1 < argc) {
+            id_range = atoi(argv[++i]);
+        } else {
+            load_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (clients < 1 || clients > LOAD_MAX_CLIENTS || seconds <= 0 ||
+        writes_percent < 0 || writes_percent > 100 || id_range < 1) {
+        load_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    LoadClient *states = (LoadClient *)calloc(clients, sizeof(LoadClient));
+    pthread_t *threads = (pthread_t *)malloc(clients * sizeof(pthread_t));
+    if (states == NULL || threads == NULL) {
+        fprintf(stderr, "Error: not enough memory for %d clients.\n", clients);
+        return EXIT_FAILURE;
+    }
+
+    double start = now_seconds();
+    deadline = start + seconds;
+    int started = 0;
+    for (; started < clients; started++) {
+        states[started].index = started;
+        states[started].state = 0x9E3779B97F4A7C15ULL * (started + 1);
+        if (pthread_create(&threads[started], NULL, run_client, &states[started]) != 0) break;
+    }
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+    double elapsed = now_seconds() - start;
+
+    // Merge every client's histograms, per type and overall
+    int failed = 0;
+    LoadStats *merged = (LoadStats *)calloc(LOAD_TYPES + 1, sizeof(LoadStats));
+    if (merged == NULL) {
+        fprintf(stderr, "Error: not enough memory for the results.\n");
+        return EXIT_FAILURE;
+    }
+    LoadStats *all = &merged[LOAD_TYPES];
+    printf("op,requests,errors,requests_per_s,p50_us,p99_us,p999_us\n");
+    for (int type = 0; type < LOAD_TYPES; type++) {
+        LoadStats *stats = &merged[type];
+        for (int t = 0; t < started; t++) {
+            const LoadStats *from = &states[t].stats[type];
+            stats->requests += from->requests;
+            stats->errors += from->errors;
+            for (int b = 0; b < LOAD_BUCKETS; b++) stats->buckets[b] += from->buckets[b];
+        }
+        if (stats->requests == 0) continue;
+        report(load_names[type], stats, elapsed);
+        all->requests += stats->requests;
+        all->errors += stats->errors;
+        for (int b = 0; b < LOAD_BUCKETS; b++) all->buckets[b] += stats->buckets[b];
+    }
+    report("all", all, elapsed);
+    for (int t = 0; t < started; t++) failed += states[t].failed;
+    if (failed > 0 || started < clients) {
+        fprintf(stderr, "%d of %d clients could not connect or lost the connection.\n",
+                failed + clients - started, clients);
+    }
+
+    free(merged);
+    free(states);
+    free(threads);
+    return failed > 0 || started < clients ? EXIT_FAILURE : EXIT_SUCCESS;
+}
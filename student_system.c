@@ -2,12 +2,113 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
 
 
+// Rosters saved by older versions, read only to migrate them
 #define FILENAME "students.txt"
 #define INITIAL_CAPACITY 5
 #define MAX_GRADES 3
 
+// ID index: open-addressing table kept at most half full (tombstones
+// included), never smaller than ID_INDEX_MIN_CAPACITY slots
+#define ID_INDEX_MIN_CAPACITY 16
+
+// Name search: matches printed per query, and the length of a trigram
+#define MAX_PRINTED_MATCHES 20
+#define TRIGRAM_LENGTH 3
+
+// Deleted positions are reused by later adds. Once more than
+// 1/COMPACT_FRACTION of the positions (and at least COMPACT_MIN_DELETED)
+// hold deleted records, the roster is compacted.
+#define COMPACT_MIN_DELETED 64
+#define COMPACT_FRACTION 4
+
+// Records converted per block when loading FILENAME
+#define IO_BLOCK_RECORDS 4096
+
+// Bulk import: a CSV file is split across up to MAX_IMPORT_THREADS
+// threads, each taking at least IMPORT_CHUNK_MIN bytes. The first
+// MAX_IMPORT_ERRORS rejected lines are listed. Exports of at least
+// REPORT_PARALLEL_MIN records are formatted across as many threads.
+#define MAX_IMPORT_THREADS 64
+#define IMPORT_CHUNK_MIN (1 << 20)
+#define MAX_IMPORT_ERRORS 10
+#define EXPORT_FLOAT_CACHE 128
+#define EXPORT_FLOAT_PROBES 4
+
+// Record store, in native byte order, STORE_PAGE_SIZE bytes a page:
+//   page 0   StoreHeader
+//   then     one region per column (ids, ages, GPAs, course numbers, live
+//            flags, details), each holding capacity entries and starting
+//            on a page boundary
+//   then     the tail, at tail_offset: a u64 Fletcher-64 checksum per
+//            data page, padded to a page, then course_count StoreCourse
+//            entries
+// Loading maps the header and data pages copy-on-write and points the
+// columns into the mapping; saving writes back only the pages changed
+// since, then a new tail and the header. The new tail never overwrites
+// the one the old header points to, so an interrupted save leaves the old
+// header valid, and the write-ahead log replays over the pages.
+#define STORE_FILENAME "students.db"
+#define STORE_TEMP_FILENAME "students.db.tmp"
+#define STORE_MAGIC "SREC"
+#define STORE_VERSION 2
+#define STORE_PAGE_SIZE 4096
+#define STORE_REGIONS 6
+
+// Write-ahead log, in native byte order: a WalHeader, then records of a
+// u32 op, a u32 payload length (a multiple of 4), the payload and a u64
+// Fletcher-64 over the three. Records are grouped for up to
+// WAL_COMMIT_MS before one write and fdatasync; a save once the log
+// passes WAL_CHECKPOINT_BYTES folds it into the store.
+#define WAL_FILENAME "students.wal"
+#define WAL_MAGIC "SWAL"
+#define WAL_VERSION 1
+#define WAL_COMMIT_MS 10
+#define WAL_CHECKPOINT_BYTES (4 << 20)
+
+// The course dictionary follows the records in FILENAME: COURSE_DICT_MAGIC,
+// an int count, then count names of COURSE_NAME_SIZE bytes. Older files
+// end after the records; the dictionary is then rebuilt from them.
+#define COURSE_DICT_MAGIC "CDIC"
+#define COURSE_NAME_SIZE 50
+
+// Sort keys per ordering, e.g. course, then GPA descending, then name
+#define MAX_SORT_KEYS 5
+
+// Reports: rosters of at least REPORT_PARALLEL_MIN students are scanned by
+// up to MAX_REPORT_THREADS threads
+#define REPORT_PARALLEL_MIN (1 << 16)
+#define MAX_REPORT_THREADS 64
+
+// Server mode: clients send one request a line over a Unix domain socket
+// and get back "OK n" and n lines of results, or "ERR reason". Reads run
+// on the client's own thread against an immutable snapshot of the roster;
+// writes go to a single writer, which applies them a batch at a time,
+// syncs the log and publishes a new snapshot. Snapshots are made of
+// SNAPSHOT_CHUNK-position chunks shared between them, so publishing copies
+// only the chunks a batch changed.
+#define SERVER_LINE_SIZE 512
+#define SERVER_REPLY_SIZE 128
+#define SERVER_MAX_CLIENTS 256
+#define SNAPSHOT_CHUNK 4096
+#define SNAPSHOT_ID_TABLE (2 * SNAPSHOT_CHUNK)
+
 
 typedef struct {
     int id;
@@ -18,11 +119,377 @@ typedef struct {
     float gpa;
 } Student;
 
+// A parsed CSV row and its line number within the import chunk
+typedef struct {
+    Student record;
+    int line;
+} ImportRow;
+
+// One thread's share of an import: the lines starting in [begin, end),
+// which may run on to limit, the end of the file
+typedef struct {
+    const char *begin;
+    const char *end;
+    const char *limit;
+    int first;                // the chunk holding line 1, which may be a header
+    ImportRow *rows;
+    int row_count;
+    int row_capacity;
+    int lines;                // lines in the chunk, blank ones included
+    int error_count;
+    int error_lines[MAX_IMPORT_ERRORS];
+    const char *error_reasons[MAX_IMPORT_ERRORS];
+    int out_of_memory;
+} ImportChunk;
+
+// One thread's share of an export: the CSV text of order[from, to)
+typedef struct {
+    const int *order;
+    int from;
+    int to;
+    char *text;
+    size_t length;
+    size_t capacity;
+    int out_of_memory;
+} ExportChunk;
+
+// Text of the grades an export thread formatted, which take few distinct
+// values. Entries are found by linear probing from a hash of the bits.
+typedef struct {
+    uint32_t bits[EXPORT_FLOAT_CACHE];
+    char text[EXPORT_FLOAT_CACHE][16];   // "" for an unused entry
+} FloatCache;
+
+// First page of the record store. The checksums are Fletcher-64.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t details_size;       // sizeof(StudentDetails), to catch layout changes
+    uint32_t capacity;           // entries in each column region
+    uint32_t slots;              // student_slots
+    uint32_t count;              // student_count
+    uint32_t course_count;
+    uint64_t generation;         // incremented by every save
+    uint64_t data_pages;
+    uint64_t tail_offset;
+    uint64_t table_checksum;     // over the page checksums
+    uint64_t courses_checksum;   // over the StoreCourse entries
+    uint64_t header_checksum;    // over every field above
+} StoreHeader;
+
+// First bytes of the write-ahead log
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t generation;   // store generation the records apply to
+} WalHeader;
+
+typedef enum {
+    WAL_PUT = 1,    // a Student, added or replacing the one with its id
+    WAL_DELETE,     // an int id
+    WAL_RENAME,     // old and new course names, COURSE_NAME_SIZE bytes each
+    WAL_PAGE        // a u64 store page number and the page as last saved
+} WalOp;
+
+// Fields of a Student that scans rarely touch
+typedef struct {
+    char name[50];
+    float grades[MAX_GRADES];
+} StudentDetails;
 
-Student *student_list = NULL;
+// The roster, stored column-wise: the fields searches, sorts and reports
+// scan (id, age, GPA, course number) in contiguous arrays, the rest in
+// student_details. A position ("slot") indexes every column. Student is
+// the record as entered and displayed; get_student/put_student convert.
+// After a load or save the columns live in the mapped record store.
+//
+// Deleting a student only clears student_live at its position, so
+// positions held by the indexes stay valid; the position goes on the free
+// list for the next add. Positions [0, student_slots) have been used,
+// student_count of them hold live records.
+int *student_ids = NULL;
+int *student_ages = NULL;
+float *student_gpas = NULL;
+int *student_course_ids = NULL;
+unsigned char *student_live = NULL;
+StudentDetails *student_details = NULL;
 int student_count = 0;
+int student_slots = 0;
 int student_capacity = 0;
 
+// Deleted positions waiting for reuse, most recently freed last
+int *free_slots = NULL;
+int free_count = 0;
+int free_capacity = 0;
+
+// One entry of the course dictionary
+typedef struct {
+    char name[COURSE_NAME_SIZE];
+    unsigned int hash;
+    int enrolled;
+} Course;
+
+// On-disk form of a course dictionary entry
+typedef struct {
+    char name[COURSE_NAME_SIZE];
+    int enrolled;
+} StoreCourse;
+
+#define COURSE_SLOT_EMPTY (-1)
+#define COURSE_SLOT_DELETED (-2)
+
+// Every distinct course name once, numbered in order of first use, with an
+// open-addressing table from name to number. Records store the number, so
+// renaming a course is a single update.
+Course *courses = NULL;
+int course_count = 0;
+int course_capacity = 0;
+int *course_table = NULL;
+int course_table_capacity = 0;
+int course_table_used = 0;   // live entries plus tombstones
+
+// One entry of the ID index. Entries hold positions rather than pointers,
+// so reallocating the columns does not invalidate them.
+typedef struct {
+    int id;
+    int slot;   // ID_SLOT_EMPTY, ID_SLOT_DELETED or a position
+} IdEntry;
+
+#define ID_SLOT_EMPTY (-1)
+#define ID_SLOT_DELETED (-2)
+
+// Hash index from student id to position. When stale it is rebuilt on the
+// next lookup; if that fails, lookups fall back to a linear scan.
+IdEntry *id_index = NULL;
+int id_index_capacity = 0;
+int id_index_used = 0;   // live entries plus tombstones
+int id_index_stale = 1;
+
+// Posting list of one case-folded trigram: ascending positions of the
+// students whose name contains it
+typedef struct {
+    uint32_t key;   // three folded name bytes, never 0; 0 marks an empty entry
+    int count;
+    int capacity;
+    int *slots;
+} TrigramList;
+
+// Positions ordered by name, ignoring case (ties by
+// position). Rebuilt on the next name search when stale.
+int *name_index = NULL;
+int name_index_count = 0;
+int name_index_capacity = 0;
+int name_index_stale = 1;
+
+// Trigram index for substring search, built on the first such search
+TrigramList *trigram_table = NULL;
+int trigram_capacity = 0;
+int trigram_used = 0;
+int trigram_built = 0;
+
+// Ascending positions of the students taking one course
+typedef struct {
+    int count;
+    int capacity;
+    int *slots;
+} PostingList;
+
+// A range search: students of course (-1 for any) whose GPA and age lie
+// in the closed ranges
+typedef struct {
+    int course;
+    float min_gpa;
+    float max_gpa;
+    int min_age;
+    int max_age;
+} RangeQuery;
+
+// Positions ordered by GPA and by age (ties by position), and a posting
+// list per course number. Rebuilt on the next range search when stale.
+int *gpa_index = NULL;
+int *age_index = NULL;
+int range_index_count = 0;
+int range_index_capacity = 0;
+PostingList *course_postings = NULL;
+int course_postings_count = 0;
+int range_index_stale = 1;
+
+typedef enum {
+    FIELD_ID,
+    FIELD_NAME,
+    FIELD_AGE,
+    FIELD_COURSE,
+    FIELD_GPA
+} SortField;
+
+typedef struct {
+    SortField field;
+    int descending;
+} SortKey;
+
+// An ordering: keys compared left to right, ties keep the previous order
+typedef struct {
+    int count;
+    SortKey keys[MAX_SORT_KEYS];
+} SortSpec;
+
+// Compact sort record: the leading keys packed into 64 bits, plus the
+// position of the student they were taken from
+typedef struct {
+    uint64_t key;
+    int index;
+} SortPair;
+
+// Aggregates of one course in a report
+typedef struct {
+    int first_slot;   // courses are reported in order of first appearance
+    int count;
+    double gpa_sum;
+    float max_gpa;
+    int top_slot;
+    int stale;        // report totals only: first_slot or the top need a rescan
+} CourseGroup;
+
+// What one thread aggregates over positions [from, to): class-wide
+// figures and one group per course number
+typedef struct {
+    int from;
+    int to;
+    double gpa_sum;
+    float max_gpa;
+    float min_gpa;
+    int top_slot;
+    CourseGroup *groups;   // course_count entries
+} ReportPartial;
+
+// Report figures kept up to date by every add, update and delete: a group
+// for the whole class (its first_slot unused) and one per course number.
+// A group whose first or best student leaves is marked stale and rescanned
+// by the next report; when the totals themselves are stale the next report
+// aggregates the roster from scratch.
+CourseGroup report_class;
+float report_min_gpa = 0;
+CourseGroup *report_courses = NULL;
+int report_course_capacity = 0;
+int report_totals_stale = 1;
+
+// A position of the roster as a snapshot holds it
+typedef struct {
+    int id;
+    int age;
+    int course;
+    float gpa;
+    int live;
+    StudentDetails details;
+} SnapshotRow;
+
+// SNAPSHOT_CHUNK positions of a snapshot, shared by every snapshot in
+// which they are unchanged. id_table hashes the ids of the live rows to
+// their index plus one (0 where empty).
+typedef struct {
+    int refs;
+    int used;
+    SnapshotRow rows[SNAPSHOT_CHUNK];
+    uint16_t id_table[SNAPSHOT_ID_TABLE];
+} SnapshotChunk;
+
+// The roster as published by the writer after a batch of writes. Readers
+// hold a reference while they use it; it is freed with the last one.
+typedef struct {
+    int refs;
+    int count;
+    int chunk_count;
+    SnapshotChunk **chunks;
+    int course_count;
+    char (*course_names)[COURSE_NAME_SIZE];
+} Snapshot;
+
+typedef enum {
+    SERVER_ADD,
+    SERVER_UPDATE,
+    SERVER_DELETE,
+    SERVER_RENAME,
+    SERVER_SAVE
+} ServerOp;
+
+// A write queued by a client thread, which waits for done
+typedef struct ServerWrite {
+    ServerOp op;
+    const char *arg;
+    char reply[SERVER_REPLY_SIZE];
+    int done;
+    struct ServerWrite *next;
+} ServerWrite;
+
+// Order display_students walks the records in, as positions (-1 where a
+// student was deleted). Sorting rewrites it instead of moving the records;
+// while inactive, records are shown in storage order. display_rank maps a
+// position back to its index in display_order.
+int *display_order = NULL;
+int display_order_count = 0;
+int display_order_capacity = 0;
+int *display_rank = NULL;
+int display_rank_capacity = 0;
+int display_order_active = 0;
+
+// The mapped record store. While store_map is set the columns point into
+// it and store_dirty flags the data pages written since the last save;
+// otherwise they are on the heap and the next save writes a new file.
+unsigned char *store_map = NULL;
+size_t store_map_length = 0;
+StoreHeader store_header;
+size_t store_region_offset[STORE_REGIONS];
+uint64_t *store_checksums = NULL;   // one per data page
+unsigned char *store_dirty = NULL;  // one flag per data page
+
+// Page checksums are verified by a background thread after a load, from
+// its own descriptor, so the load itself touches no data pages
+pthread_t store_verifier;
+pthread_mutex_t store_verify_lock = PTHREAD_MUTEX_INITIALIZER;
+int store_verifier_running = 0;
+int store_verify_stop = 0;
+int store_verify_fd = -1;
+uint64_t store_verify_checked = 0;
+uint64_t store_verify_bad = 0;
+uint64_t store_verify_first_bad = 0;
+
+// Write-ahead log. Records are queued by the main thread and written in
+// groups by the flusher thread; everything below wal_fd is under wal_lock.
+int wal_fd = -1;
+int wal_flusher_running = 0;
+pthread_t wal_flusher;
+pthread_mutex_t wal_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t wal_wake = PTHREAD_COND_INITIALIZER;      // records queued or a flush requested
+pthread_cond_t wal_flushed = PTHREAD_COND_INITIALIZER;   // wal_durable advanced or the log failed
+unsigned char *wal_queue = NULL;
+size_t wal_queue_length = 0;
+size_t wal_queue_capacity = 0;
+uint64_t wal_logged = 0;    // bytes ever queued
+uint64_t wal_durable = 0;   // bytes ever synced
+off_t wal_end = 0;          // file offset of the next group
+int wal_flush_now = 0;
+int wal_stop = 0;
+int wal_failed = 0;
+int wal_unapplied = 0;      // replay could not apply every record: saving would lose them
+
+// Server mode. snapshot_current and every reference count are under
+// snapshot_lock; snapshot_dirty, one flag per chunk of snapshot_current
+// changed since it was published, belongs to the writer. The write queue
+// and client list are under server_lock.
+Snapshot *snapshot_current = NULL;
+pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+unsigned char *snapshot_dirty = NULL;
+int snapshot_dirty_count = 0;
+pthread_mutex_t server_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t server_queued = PTHREAD_COND_INITIALIZER;    // a write queued or server_stop set
+pthread_cond_t server_replied = PTHREAD_COND_INITIALIZER;   // writes done or a client gone
+ServerWrite *server_queue_head = NULL;
+ServerWrite *server_queue_tail = NULL;
+int server_client_fds[SERVER_MAX_CLIENTS];
+int server_clients = 0;
+int server_stop = 0;
+
 // Function Prototypes
 void display_menu();
 void initialize_list();
@@ -39,511 +506,4118 @@ int get_unique_id();
 void save_records();
 void load_records();
 void cleanup_memory();
+int find_student(int id);
+void id_index_set(int id, int slot);
+void id_index_remove(int id);
+void id_index_invalidate();
+void name_index_invalidate();
+void name_index_add(int slot);
+void name_index_forget(int slot);
+void name_index_remap(const int *new_slot);
+void range_index_invalidate();
+void range_index_add(int slot);
+void range_index_forget(int slot);
+void range_index_remap(const int *new_slot);
+void report_totals_invalidate();
+void report_totals_add(int slot);
+void report_totals_forget(int slot);
+void report_totals_remap(const int *new_slot);
+void display_order_add(int slot);
+void display_order_remove(int slot);
+void display_order_remap(const int *new_slot);
+int course_intern(const char *name);
+void course_clear();
+void rename_course();
+int import_csv(const char *path);
+int export_csv(const char *path);
+int run_batch(int argc, char *argv[]);
+void store_mark(int first, int count);
+int store_detach();
+void store_close();
+void store_report_damage();
+void wal_log_student(int slot);
+void wal_log(uint32_t op, const void *payload, uint32_t length);
+void wal_checkpoint_if_due();
+void wal_close();
+int wal_save_pages(int store_fd);
+void wal_log_rename(const char *old_name, const char *new_name);
+void snapshot_mark(int first, int count);
+int run_server(const char *path);
+void server_signal_set(sigset_t *signals);
 
-// Core Functions
-void initialize_list() {
-    student_list = (Student *)malloc(INITIAL_CAPACITY * sizeof(Student));
-    if (student_list == NULL) {
-        perror("Error allocating initial memory");
-        exit(EXIT_FAILURE);
+// Record Storage
+
+static const char *student_name(int slot) {
+    return student_details[slot].name;
+}
+
+static const char *student_course(int slot) {
+    return courses[student_course_ids[slot]].name;
+}
+
+void get_student(int slot, Student *out) {
+    const StudentDetails *d = &student_details[slot];
+    out->id = student_ids[slot];
+    memcpy(out->name, d->name, sizeof(out->name));
+    out->age = student_ages[slot];
+    memcpy(out->course, student_course(slot), sizeof(out->course));
+    memcpy(out->grades, d->grades, sizeof(out->grades));
+    out->gpa = student_gpas[slot];
+}
+
+// Stores s at slot, replacing the record there if it is live, and marks
+// it live. Returns 0 (storing nothing) if the course could not be interned.
+int put_student(int slot, const Student *s) {
+    int course = course_intern(s->course);
+    if (course < 0) return 0;
+    if (student_live[slot]) {
+        courses[student_course_ids[slot]].enrolled--;
+        range_index_forget(slot);
+        report_totals_forget(slot);
     }
-    student_capacity = INITIAL_CAPACITY;
-    printf("System initialized with capacity for %d students.\n", student_capacity);
+    courses[course].enrolled++;
+    student_live[slot] = 1;
+
+    StudentDetails *d = &student_details[slot];
+    student_ids[slot] = s->id;
+    memcpy(d->name, s->name, sizeof(d->name));
+    student_ages[slot] = s->age;
+    student_course_ids[slot] = course;
+    memcpy(d->grades, s->grades, sizeof(d->grades));
+    student_gpas[slot] = s->gpa;
+    store_mark(slot, 1);
+    range_index_add(slot);
+    report_totals_add(slot);
+    return 1;
 }
 
-// Resize the array using realloc
-void check_and_resize() {
-    if (student_count >= student_capacity) {
-        student_capacity *= 2; 
-        Student *temp = (Student *)realloc(student_list, student_capacity * sizeof(Student));
-        
-        if (temp == NULL) {
-            perror("Error reallocating memory");
-            student_capacity /= 2;
-            printf("Memory resize failed. Current student count: %d\n", student_count);
-        } else {
-            student_list = temp;
-            printf("Memory successfully resized to capacity: %d\n", student_capacity);
-        }
+static unsigned int string_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s != '\0'; s++) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+}
+
+// Moves count records from position from to position to in every column
+static void move_students(int to, int from, int count) {
+    memmove(&student_ids[to], &student_ids[from], count * sizeof(int));
+    memmove(&student_ages[to], &student_ages[from], count * sizeof(int));
+    memmove(&student_gpas[to], &student_gpas[from], count * sizeof(float));
+    memmove(&student_course_ids[to], &student_course_ids[from], count * sizeof(int));
+    memmove(&student_live[to], &student_live[from], count);
+    memmove(&student_details[to], &student_details[from], count * sizeof(StudentDetails));
+    store_mark(to, count);
+}
+
+// Reallocates every column to hold capacity records, moving them out of
+// the record store first. Returns 0 on failure; student_capacity is then
+// the smaller of the old and requested sizes, which every column can
+// still hold.
+static int resize_columns(int capacity) {
+    if (store_map != NULL && !store_detach()) return 0;
+    int *ids = (int *)realloc(student_ids, capacity * sizeof(int));
+    if (ids != NULL) student_ids = ids;
+    int *ages = (int *)realloc(student_ages, capacity * sizeof(int));
+    if (ages != NULL) student_ages = ages;
+    float *gpas = (float *)realloc(student_gpas, capacity * sizeof(float));
+    if (gpas != NULL) student_gpas = gpas;
+    int *course_ids = (int *)realloc(student_course_ids, capacity * sizeof(int));
+    if (course_ids != NULL) student_course_ids = course_ids;
+    unsigned char *live = (unsigned char *)realloc(student_live, capacity);
+    if (live != NULL) student_live = live;
+    StudentDetails *details = (StudentDetails *)realloc(student_details, capacity * sizeof(StudentDetails));
+    if (details != NULL) student_details = details;
+
+    if (ids == NULL || ages == NULL || gpas == NULL || course_ids == NULL ||
+        live == NULL || details == NULL) {
+        if (capacity < student_capacity) student_capacity = capacity;
+        return 0;
     }
+    student_capacity = capacity;
+    return 1;
 }
 
-float calculate_gpa(float grades[]) {
-    float sum = 0;
-    for (int i = 0; i < MAX_GRADES; i++) {
-        sum += grades[i];
+// Position for a new record: a freed one if any, else the next unused
+// one. Returns -1 if the columns are full.
+int allocate_slot() {
+    if (free_count > 0) {
+        int slot = free_slots[--free_count];
+        name_index_forget(slot);
+        return slot;
     }
-    return sum / MAX_GRADES;
+    if (student_slots >= student_capacity) return -1;
+    student_live[student_slots] = 0;
+    store_mark(student_slots, 1);
+    return student_slots++;
 }
 
-int get_unique_id() {
-    int id;
-    int is_unique;
-    do {
-        is_unique = 1;
-        printf("Enter Student ID: ");
-        if (scanf("%d", &id) != 1) {
-            printf("Invalid input. Please enter a number.\n");
-            while (getchar() != '\n');
+// Marks the record at slot deleted and queues the position for reuse. If
+// the free list cannot grow the position waits for the next compaction.
+void release_slot(int slot) {
+    student_live[slot] = 0;
+    store_mark(slot, 1);
+    if (free_count == free_capacity) {
+        int capacity = free_capacity > 0 ? free_capacity * 2 : INITIAL_CAPACITY;
+        int *temp = (int *)realloc(free_slots, capacity * sizeof(int));
+        if (temp == NULL) return;
+        free_slots = temp;
+        free_capacity = capacity;
+    }
+    free_slots[free_count++] = slot;
+}
+
+// Moves every live record down over the deleted ones, keeping their
+// order, and renumbers the indexes to match. Gives memory back once the
+// roster fills less than a quarter of the columns.
+void compact_students() {
+    int *new_slot = (int *)malloc((student_slots + 1) * sizeof(int));
+    if (new_slot == NULL) return;
+
+    int kept = 0;
+    for (int i = 0; i < student_slots; i++) {
+        if (!student_live[i]) {
+            new_slot[i] = -1;
             continue;
         }
-        for (int i = 0; i < student_count; i++) {
-            if (student_list[i].id == id) {
-                printf("Error: ID %d already exists. Please enter a unique ID.\n", id);
-                is_unique = 0;
-                break;
-            }
+        if (kept != i) move_students(kept, i, 1);
+        new_slot[i] = kept++;
+    }
+    student_slots = kept;
+    free_count = 0;
+
+    id_index_invalidate();
+    name_index_remap(new_slot);
+    range_index_remap(new_slot);
+    report_totals_remap(new_slot);
+    display_order_remap(new_slot);
+    free(new_slot);
+
+    if (student_capacity > INITIAL_CAPACITY && student_slots < student_capacity / 4) {
+        int capacity = student_capacity / 2;
+        if (capacity < INITIAL_CAPACITY) capacity = INITIAL_CAPACITY;
+        resize_columns(capacity);
+    }
+}
+
+static void maybe_compact(void) {
+    int deleted = student_slots - student_count;
+    if (deleted >= COMPACT_MIN_DELETED && deleted > student_slots / COMPACT_FRACTION) {
+        compact_students();
+    }
+}
+
+// Adds s at a free position and to the indexes. Returns the position, or
+// -1 if the columns are full or out of memory.
+int insert_student(const Student *s) {
+    int slot = allocate_slot();
+    if (slot < 0 || !put_student(slot, s)) {
+        if (slot >= 0) release_slot(slot);
+        return -1;
+    }
+    student_count++;
+    id_index_set(s->id, slot);
+    name_index_add(slot);
+    display_order_add(slot);
+    return slot;
+}
+
+// Stores s over the student with its id, or adds it if there is none.
+// Returns the position, or -1 if out of memory.
+int upsert_student(const Student *s) {
+    int slot = find_student(s->id);
+    if (slot >= 0) {
+        if (strcmp(student_name(slot), s->name) != 0) name_index_invalidate();
+        return put_student(slot, s) ? slot : -1;
+    }
+    if (free_count == 0 && student_slots >= student_capacity &&
+        !resize_columns(student_capacity * 2)) {
+        return -1;
+    }
+    return insert_student(s);
+}
+
+// Deletes the student at slot. The record stays in place as a tombstone;
+// the name index keeps it until the position is reused.
+void remove_student(int slot) {
+    courses[student_course_ids[slot]].enrolled--;
+    id_index_remove(student_ids[slot]);
+    range_index_forget(slot);
+    report_totals_forget(slot);
+    display_order_remove(slot);
+    release_slot(slot);
+    student_count--;
+    maybe_compact();
+}
+
+// Course Dictionary
+
+// Table entry holding name, or the first free entry on its probe sequence
+static int *course_probe(const char *name, unsigned int hash) {
+    unsigned int mask = course_table_capacity - 1;
+    int *tombstone = NULL;
+    for (unsigned int i = hash & mask; ; i = (i + 1) & mask) {
+        int *e = &course_table[i];
+        if (*e == COURSE_SLOT_EMPTY) return tombstone != NULL ? tombstone : e;
+        if (*e == COURSE_SLOT_DELETED) {
+            if (tombstone == NULL) tombstone = e;
+        } else if (courses[*e].hash == hash && strcmp(courses[*e].name, name) == 0) {
+            return e;
         }
-    } while (!is_unique);
-    return id;
+    }
 }
 
-// CRUD Operations 
+// Rehashes every course into a table with room for one more, dropping
+// tombstones. Returns 0 if out of memory.
+static int course_table_rebuild(void) {
+    int capacity = 16;
+    while (capacity / 2 < course_count + 1) capacity *= 2;
+    int *table = (int *)malloc(capacity * sizeof(int));
+    if (table == NULL) return 0;
+    for (int i = 0; i < capacity; i++) table[i] = COURSE_SLOT_EMPTY;
+    free(course_table);
+    course_table = table;
+    course_table_capacity = capacity;
+    course_table_used = course_count;
+    for (int c = 0; c < course_count; c++) *course_probe(courses[c].name, courses[c].hash) = c;
+    return 1;
+}
 
-void add_student() {
-    check_and_resize();
-    
-    Student *new_student = &student_list[student_count];
-    
-    // Get ID 
-    new_student->id = get_unique_id();
+// Number of the course with this name, or -1
+int course_lookup(const char *name) {
+    if (course_count == 0) return -1;
+    int *e = course_probe(name, string_hash(name));
+    return *e >= 0 ? *e : -1;
+}
 
-    // Get Name
-    printf("Enter Name: ");
-    while (getchar() != '\n'); 
-    fgets(new_student->name, 50, stdin);
-    new_student->name[strcspn(new_student->name, "\n")] = 0; 
+// Number of the course with this name, added if new. -1 if out of memory.
+int course_intern(const char *name) {
+    int existing = course_lookup(name);
+    if (existing >= 0) return existing;
 
-    // Get Age
-    do {
-        printf("Enter Age (18-99): ");
-        if (scanf("%d", &new_student->age) != 1 || new_student->age < 18 || new_student->age > 99) {
-            printf("Invalid age entered.\n");
-            while (getchar() != '\n');
-        } else {
-            break;
+    if ((course_table_used + 1) * 2 > course_table_capacity && !course_table_rebuild()) return -1;
+    if (course_count == course_capacity) {
+        int capacity = course_capacity > 0 ? course_capacity * 2 : 16;
+        Course *temp = (Course *)realloc(courses, capacity * sizeof(Course));
+        if (temp == NULL) return -1;
+        courses = temp;
+        course_capacity = capacity;
+    }
+
+    Course *c = &courses[course_count];
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->hash = string_hash(c->name);
+    int *e = course_probe(c->name, c->hash);
+    if (*e == COURSE_SLOT_EMPTY) course_table_used++;
+    *e = course_count;
+    return course_count++;
+}
+
+// Renames course id for every student enrolled in it. Returns 0 if another
+// course already has the new name.
+int course_rename(int id, const char *name) {
+    int existing = course_lookup(name);
+    if (existing >= 0) return existing == id;
+
+    Course *c = &courses[id];
+    *course_probe(c->name, c->hash) = COURSE_SLOT_DELETED;
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->hash = string_hash(c->name);
+    // The tombstone just left guarantees a free entry on the probe path
+    int *e = course_probe(c->name, c->hash);
+    if (*e == COURSE_SLOT_EMPTY) course_table_used++;
+    *e = id;
+    return 1;
+}
+
+void course_clear() {
+    free(courses);
+    free(course_table);
+    courses = NULL;
+    course_table = NULL;
+    course_count = 0;
+    course_capacity = 0;
+    course_table_capacity = 0;
+    course_table_used = 0;
+}
+
+// ID Index
+
+static unsigned int id_hash(int id) {
+    uint32_t h = (uint32_t)id * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+// Entry holding id, or the first free entry on its probe sequence
+static IdEntry *id_index_probe(int id) {
+    unsigned int mask = id_index_capacity - 1;
+    IdEntry *tombstone = NULL;
+    for (unsigned int i = id_hash(id) & mask; ; i = (i + 1) & mask) {
+        IdEntry *e = &id_index[i];
+        if (e->slot == ID_SLOT_EMPTY) return tombstone != NULL ? tombstone : e;
+        if (e->slot == ID_SLOT_DELETED) {
+            if (tombstone == NULL) tombstone = e;
+        } else if (e->id == id) {
+            return e;
         }
-    } while (1);
+    }
+}
 
-    // Get Course
-    printf("Enter Course: ");
-    while (getchar() != '\n');
-    fgets(new_student->course, 50, stdin);
-    new_student->course[strcspn(new_student->course, "\n")] = 0;
+// Fills a fresh table sized for min_entries from student_ids.
+// Returns 0 if out of memory (the index is then left stale).
+static int id_index_rebuild(int min_entries) {
+    int capacity = ID_INDEX_MIN_CAPACITY;
+    while (capacity / 2 < min_entries) {
+        if (capacity > INT32_MAX / 4) return 0;
+        capacity *= 2;
+    }
 
-    // Get Grades
-    printf("Enter %d Grades (0.0 - 4.0):\n", MAX_GRADES);
-    for (int i = 0; i < MAX_GRADES; i++) {
-        do {
-            printf("  Grade %d: ", i + 1);
-            if (scanf("%f", &new_student->grades[i]) != 1 || new_student->grades[i] < 0.0 || new_student->grades[i] > 4.0) {
-                printf("Invalid grade. Must be between 0.0 and 4.0.\n");
-                while (getchar() != '\n');
-            } else {
-                break;
-            }
-        } while (1);
+    IdEntry *table = (IdEntry *)malloc(capacity * sizeof(IdEntry));
+    if (table == NULL) {
+        id_index_stale = 1;
+        return 0;
     }
+    for (int i = 0; i < capacity; i++) table[i].slot = ID_SLOT_EMPTY;
+    free(id_index);
+    id_index = table;
+    id_index_capacity = capacity;
+    id_index_used = 0;
+    id_index_stale = 0;
 
-    // Calculate GPA
-    new_student->gpa = calculate_gpa(new_student->grades);
-    
-    student_count++;
-    printf("\nStudent %s added successfully (GPA: %.2f).\n", new_student->name, new_student->gpa);
+    for (int i = 0; i < student_slots; i++) {
+        if (!student_live[i]) continue;
+        IdEntry *e = id_index_probe(student_ids[i]);
+        if (e->slot == ID_SLOT_EMPTY) id_index_used++;
+        e->id = student_ids[i];
+        e->slot = i;
+    }
+    return 1;
 }
 
-void display_students() {
-    if (student_count == 0) {
-        printf("\n-- No records to display. --\n");
-        return;
+void id_index_invalidate() {
+    id_index_stale = 1;
+}
+
+// Records that id now lives at slot (a new entry or a moved one)
+void id_index_set(int id, int slot) {
+    if (id_index_stale) return;
+    if (id_index_used + 1 > id_index_capacity / 2) {
+        // Grow, or just clear tombstones if the live entries still fit
+        if (!id_index_rebuild(student_count + 1)) return;
     }
-    
-    printf("\n--- Student Records (%d/%d) ---\n", student_count, student_capacity);
-    printf("ID | Name            | Age | Course         | Grades (%.1f avg) | GPA\n", (float)MAX_GRADES);
-    printf("------------------------------------------------------------------------\n");
-    for (int i = 0; i < student_count; i++) {
-        printf("%-3d| %-15s | %-3d | %-14s | ", 
-            student_list[i].id, 
-            student_list[i].name, 
-            student_list[i].age, 
-            student_list[i].course);
-        
-        for (int j = 0; j < MAX_GRADES; j++) {
-            printf("%.1f ", student_list[i].grades[j]);
+    IdEntry *e = id_index_probe(id);
+    if (e->slot == ID_SLOT_EMPTY) id_index_used++;
+    e->id = id;
+    e->slot = slot;
+}
+
+void id_index_remove(int id) {
+    if (id_index_stale) return;
+    IdEntry *e = id_index_probe(id);
+    if (e->slot >= 0) e->slot = ID_SLOT_DELETED;
+}
+
+// Position of the student with this id, or -1
+int find_student(int id) {
+    if (id_index_stale && !id_index_rebuild(student_count)) {
+        for (int i = 0; i < student_slots; i++) {
+            if (student_live[i] && student_ids[i] == id) return i;
         }
-        printf("| %.2f\n", student_list[i].gpa);
+        return -1;
     }
-    printf("------------------------------------------------------------------------\n");
+    IdEntry *e = id_index_probe(id);
+    return e->slot >= 0 ? e->slot : -1;
 }
 
-void delete_student() {
-    if (student_count == 0) {
-        printf("No students to delete.\n");
-        return;
+// Name Index
+// Case-insensitive exact and prefix queries binary search the sorted
+// name_index; substring queries intersect trigram posting lists.
+
+static int name_compare(const void *a, const void *b) {
+    int slot_a = *(const int *)a;
+    int slot_b = *(const int *)b;
+    int cmp = strcasecmp(student_name(slot_a), student_name(slot_b));
+    if (cmp != 0) return cmp;
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+static int name_index_rebuild(void) {
+    if (name_index_capacity < student_count) {
+        int *temp = (int *)realloc(name_index, student_count * sizeof(int));
+        if (temp == NULL) return 0;
+        name_index = temp;
+        name_index_capacity = student_count;
     }
+    int count = 0;
+    for (int i = 0; i < student_slots; i++) {
+        if (student_live[i]) name_index[count++] = i;
+    }
+    if (count > 1) qsort(name_index, count, sizeof(int), name_compare);
+    name_index_count = count;
+    name_index_stale = 0;
+    return 1;
+}
 
-    int id_to_delete;
-    printf("Enter ID of student to delete: ");
-    if (scanf("%d", &id_to_delete) != 1) {
-        printf("Invalid input.\n");
-        while (getchar() != '\n');
-        return;
+static void trigram_clear(void) {
+    for (int i = 0; i < trigram_capacity; i++) free(trigram_table[i].slots);
+    free(trigram_table);
+    trigram_table = NULL;
+    trigram_capacity = 0;
+    trigram_used = 0;
+    trigram_built = 0;
+}
+
+// Drops both name indexes (positions moved or names changed)
+void name_index_invalidate() {
+    name_index_stale = 1;
+    if (trigram_built) trigram_clear();
+}
+
+static uint32_t trigram_key(const char *s) {
+    return ((uint32_t)(unsigned char)tolower((unsigned char)s[0]) << 16) |
+           ((uint32_t)(unsigned char)tolower((unsigned char)s[1]) << 8) |
+           (uint32_t)(unsigned char)tolower((unsigned char)s[2]);
+}
+
+// Table entry for key, or the empty entry where it would go
+static TrigramList *trigram_probe(uint32_t key) {
+    unsigned int mask = trigram_capacity - 1;
+    for (unsigned int i = ((key * 0x9E3779B1u) >> 8) & mask; ; i = (i + 1) & mask) {
+        if (trigram_table[i].key == key || trigram_table[i].key == 0) return &trigram_table[i];
+    }
+}
+
+static int trigram_grow(void) {
+    int capacity = trigram_capacity > 0 ? trigram_capacity * 2 : 1024;
+    TrigramList *old = trigram_table;
+    int old_capacity = trigram_capacity;
+    trigram_table = (TrigramList *)calloc(capacity, sizeof(TrigramList));
+    if (trigram_table == NULL) {
+        trigram_table = old;
+        return 0;
+    }
+    trigram_capacity = capacity;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].key != 0) *trigram_probe(old[i].key) = old[i];
+    }
+    free(old);
+    return 1;
+}
+
+// Index of the first entry of the list not below slot
+static int trigram_find(const TrigramList *list, int slot) {
+    int lo = 0, hi = list->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (list->slots[mid] < slot) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Adds slot to the posting list of every trigram in its name, in order.
+// Positions above every listed one, as when building, are appended.
+// Returns 0 if out of memory.
+static int trigram_add(int slot) {
+    const char *name = student_name(slot);
+    size_t length = strlen(name);
+    for (size_t i = 0; i + TRIGRAM_LENGTH <= length; i++) {
+        uint32_t key = trigram_key(name + i);
+        if ((trigram_used + 1) * 2 > trigram_capacity && !trigram_grow()) return 0;
+
+        TrigramList *list = trigram_probe(key);
+        if (list->key == 0) {
+            list->key = key;
+            trigram_used++;
+        }
+        int at = list->count;
+        if (at > 0 && list->slots[at - 1] >= slot) {
+            at = trigram_find(list, slot);
+            // A name repeating a trigram lists the slot once
+            if (list->slots[at] == slot) continue;
+        }
+        if (list->count == list->capacity) {
+            int capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+            int *temp = (int *)realloc(list->slots, capacity * sizeof(int));
+            if (temp == NULL) return 0;
+            list->slots = temp;
+            list->capacity = capacity;
+        }
+        memmove(&list->slots[at + 1], &list->slots[at], (list->count - at) * sizeof(int));
+        list->slots[at] = slot;
+        list->count++;
+    }
+    return 1;
+}
+
+// Takes slot out of the posting list of every trigram in its name
+static void trigram_remove(int slot) {
+    if (trigram_capacity == 0) return;
+    const char *name = student_name(slot);
+    size_t length = strlen(name);
+    for (size_t i = 0; i + TRIGRAM_LENGTH <= length; i++) {
+        uint32_t key = trigram_key(name + i);
+        TrigramList *list = trigram_probe(key);
+        if (list->key != key) continue;
+        int at = trigram_find(list, slot);
+        if (at < list->count && list->slots[at] == slot) {
+            memmove(&list->slots[at], &list->slots[at + 1], (list->count - at - 1) * sizeof(int));
+            list->count--;
+        }
+    }
+}
+
+static int trigram_build(void) {
+    trigram_clear();
+    trigram_built = 1;
+    for (int i = 0; i < student_slots; i++) {
+        if (student_live[i] && !trigram_add(i)) {
+            trigram_clear();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Inserts slot into the sorted name index. Returns 0 if out of memory.
+static int name_index_insert(int slot) {
+    if (name_index_count == name_index_capacity) {
+        int capacity = name_index_capacity > 0 ? name_index_capacity * 2 : INITIAL_CAPACITY;
+        int *temp = (int *)realloc(name_index, capacity * sizeof(int));
+        if (temp == NULL) return 0;
+        name_index = temp;
+        name_index_capacity = capacity;
+    }
+    // Lower bound on (name, position)
+    int lo = 0, hi = name_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (name_compare(&name_index[mid], &slot) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    memmove(&name_index[lo + 1], &name_index[lo], (name_index_count - lo) * sizeof(int));
+    name_index[lo] = slot;
+    name_index_count++;
+    return 1;
+}
+
+// Keeps both name indexes in step with a student stored at slot
+void name_index_add(int slot) {
+    if (!name_index_stale && !name_index_insert(slot)) name_index_stale = 1;
+    if (trigram_built && !trigram_add(slot)) trigram_clear();
+}
+
+// Drops the deleted record at slot, whose name is still in place, before
+// the position is reused. Deleted records are otherwise left in the name
+// indexes and skipped by searches until the next compaction.
+void name_index_forget(int slot) {
+    if (trigram_built) trigram_remove(slot);
+    if (name_index_stale) return;
+    int lo = 0, hi = name_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (name_compare(&name_index[mid], &slot) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < name_index_count && name_index[lo] == slot) {
+        memmove(&name_index[lo], &name_index[lo + 1], (name_index_count - lo - 1) * sizeof(int));
+        name_index_count--;
+    }
+}
+
+// Renumbers the name index after a compaction, dropping deleted records.
+// Compaction keeps positions in order, so the index stays sorted.
+void name_index_remap(const int *new_slot) {
+    if (trigram_built) trigram_clear();
+    if (name_index_stale) return;
+    int kept = 0;
+    for (int k = 0; k < name_index_count; k++) {
+        int slot = new_slot[name_index[k]];
+        if (slot >= 0) name_index[kept++] = slot;
+    }
+    name_index_count = kept;
+}
+
+// Range of name_index whose names start with prefix (case-insensitive).
+// Returns the number of matches and sets *first, or -1 if out of memory.
+int find_name_prefix(const char *prefix, int *first) {
+    if (name_index_stale && !name_index_rebuild()) return -1;
+    size_t length = strlen(prefix);
+
+    int lo = 0, hi = name_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strncasecmp(student_name(name_index[mid]), prefix, length) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    *first = lo;
+    hi = name_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strncasecmp(student_name(name_index[mid]), prefix, length) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo - *first;
+}
+
+// Positions of every student whose name contains text (case-insensitive),
+// ascending. Returns the count or -1; *matches must be freed.
+int find_name_substring(const char *text, int **matches) {
+    size_t length = strlen(text);
+    *matches = NULL;
+
+    // Candidates: the shortest posting list among the query's trigrams,
+    // or every position if the query is too short to have one
+    const int *candidates = NULL;
+    int candidate_count = student_slots;
+    if (length >= TRIGRAM_LENGTH && (trigram_built || trigram_build())) {
+        for (size_t i = 0; i + TRIGRAM_LENGTH <= length; i++) {
+            uint32_t key = trigram_key(text + i);
+            TrigramList *list = trigram_capacity > 0 ? trigram_probe(key) : NULL;
+            int count = (list != NULL && list->key == key) ? list->count : 0;
+            if (candidates == NULL || count < candidate_count) {
+                candidates = count > 0 ? list->slots : NULL;
+                candidate_count = count;
+                if (count == 0) return 0;
+            }
+        }
+    }
+
+    int *out = (int *)malloc((candidate_count > 0 ? candidate_count : 1) * sizeof(int));
+    if (out == NULL) return -1;
+    int found = 0;
+    for (int c = 0; c < candidate_count; c++) {
+        int slot = candidates != NULL ? candidates[c] : c;
+        if (!student_live[slot]) continue;
+        const char *name = student_name(slot);
+        for (const char *p = name; *p != '\0'; p++) {
+            if (strncasecmp(p, text, length) == 0) {
+                out[found++] = slot;
+                break;
+            }
+        }
+    }
+    *matches = out;
+    return found;
+}
+
+// Range Index
+// GPA and age ranges binary search their sorted index and a course is one
+// posting list. A query walks whichever gives the fewest candidates and
+// checks the other conditions on the columns.
+
+static int gpa_compare(const void *a, const void *b) {
+    int slot_a = *(const int *)a;
+    int slot_b = *(const int *)b;
+    float gpa_a = student_gpas[slot_a], gpa_b = student_gpas[slot_b];
+    if (gpa_a != gpa_b) return gpa_a < gpa_b ? -1 : 1;
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+static int age_compare(const void *a, const void *b) {
+    int slot_a = *(const int *)a;
+    int slot_b = *(const int *)b;
+    int age_a = student_ages[slot_a], age_b = student_ages[slot_b];
+    if (age_a != age_b) return (age_a > age_b) - (age_a < age_b);
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+static int slot_compare(const void *a, const void *b) {
+    int slot_a = *(const int *)a;
+    int slot_b = *(const int *)b;
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+// Index of the first entry of the sorted index not ordered before slot
+static int range_lower_bound(const int *index, int count, int slot,
+                             int (*compare)(const void *, const void *)) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (compare(&index[mid], &slot) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Inserts slot into the sorted index, which has room for it
+static void range_insert(int *index, int count, int slot,
+                         int (*compare)(const void *, const void *)) {
+    int at = range_lower_bound(index, count, slot, compare);
+    memmove(&index[at + 1], &index[at], (count - at) * sizeof(int));
+    index[at] = slot;
+}
+
+// Removes slot from the sorted index. Returns 1 if it was there.
+static int range_remove(int *index, int count, int slot,
+                        int (*compare)(const void *, const void *)) {
+    int at = range_lower_bound(index, count, slot, compare);
+    if (at == count || index[at] != slot) return 0;
+    memmove(&index[at], &index[at + 1], (count - at - 1) * sizeof(int));
+    return 1;
+}
+
+// Makes room for a posting list per course. Returns 0 if out of memory.
+static int course_postings_reserve(int count) {
+    if (count <= course_postings_count) return 1;
+    int capacity = course_postings_count > 0 ? course_postings_count * 2 : 16;
+    if (capacity < count) capacity = count;
+    PostingList *temp = (PostingList *)realloc(course_postings, capacity * sizeof(PostingList));
+    if (temp == NULL) return 0;
+    memset(&temp[course_postings_count], 0, (capacity - course_postings_count) * sizeof(PostingList));
+    course_postings = temp;
+    course_postings_count = capacity;
+    return 1;
+}
+
+// Appends slot to the list if it is the highest position there, else
+// inserts it in order. Returns 0 if out of memory.
+static int posting_insert(PostingList *list, int slot) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+        int *temp = (int *)realloc(list->slots, capacity * sizeof(int));
+        if (temp == NULL) return 0;
+        list->slots = temp;
+        list->capacity = capacity;
+    }
+    if (list->count == 0 || list->slots[list->count - 1] < slot) {
+        list->slots[list->count++] = slot;
+    } else {
+        range_insert(list->slots, list->count++, slot, slot_compare);
+    }
+    return 1;
+}
+
+static int range_index_rebuild(void) {
+    if (range_index_capacity < student_count) {
+        int *gpas = (int *)realloc(gpa_index, student_count * sizeof(int));
+        if (gpas == NULL) return 0;
+        gpa_index = gpas;
+        int *ages = (int *)realloc(age_index, student_count * sizeof(int));
+        if (ages == NULL) return 0;
+        age_index = ages;
+        range_index_capacity = student_count;
+    }
+    if (!course_postings_reserve(course_count)) return 0;
+    for (int c = 0; c < course_postings_count; c++) course_postings[c].count = 0;
+
+    int count = 0;
+    for (int i = 0; i < student_slots; i++) {
+        if (!student_live[i]) continue;
+        gpa_index[count] = i;
+        age_index[count++] = i;
+        if (!posting_insert(&course_postings[student_course_ids[i]], i)) return 0;
+    }
+    if (count > 1) {
+        qsort(gpa_index, count, sizeof(int), gpa_compare);
+        qsort(age_index, count, sizeof(int), age_compare);
+    }
+    range_index_count = count;
+    range_index_stale = 0;
+    return 1;
+}
+
+void range_index_invalidate() {
+    range_index_stale = 1;
+}
+
+// Adds the student just stored at slot to the range indexes
+void range_index_add(int slot) {
+    if (range_index_stale) return;
+    if (range_index_count == range_index_capacity) {
+        int capacity = range_index_capacity > 0 ? range_index_capacity * 2 : INITIAL_CAPACITY;
+        int *gpas = (int *)realloc(gpa_index, capacity * sizeof(int));
+        if (gpas != NULL) gpa_index = gpas;
+        int *ages = (int *)realloc(age_index, capacity * sizeof(int));
+        if (ages != NULL) age_index = ages;
+        if (gpas == NULL || ages == NULL) {
+            range_index_stale = 1;
+            return;
+        }
+        range_index_capacity = capacity;
+    }
+    int course = student_course_ids[slot];
+    if (!course_postings_reserve(course + 1) || !posting_insert(&course_postings[course], slot)) {
+        range_index_stale = 1;
+        return;
+    }
+    range_insert(gpa_index, range_index_count, slot, gpa_compare);
+    range_insert(age_index, range_index_count, slot, age_compare);
+    range_index_count++;
+}
+
+// Drops the student at slot, whose record is still in place, before it
+// is deleted or overwritten
+void range_index_forget(int slot) {
+    if (range_index_stale) return;
+    if (range_remove(gpa_index, range_index_count, slot, gpa_compare) &&
+        range_remove(age_index, range_index_count, slot, age_compare)) {
+        range_index_count--;
+    }
+    PostingList *list = &course_postings[student_course_ids[slot]];
+    if (range_remove(list->slots, list->count, slot, slot_compare)) list->count--;
+}
+
+// Renumbers the range indexes after a compaction. Compaction keeps
+// positions in order, so every index stays sorted.
+void range_index_remap(const int *new_slot) {
+    if (range_index_stale) return;
+    int kept = 0;
+    for (int k = 0; k < range_index_count; k++) {
+        int slot = new_slot[gpa_index[k]];
+        if (slot >= 0) gpa_index[kept++] = slot;
+    }
+    kept = 0;
+    for (int k = 0; k < range_index_count; k++) {
+        int slot = new_slot[age_index[k]];
+        if (slot >= 0) age_index[kept++] = slot;
+    }
+    range_index_count = kept;
+    for (int c = 0; c < course_postings_count; c++) {
+        PostingList *list = &course_postings[c];
+        kept = 0;
+        for (int k = 0; k < list->count; k++) {
+            int slot = new_slot[list->slots[k]];
+            if (slot >= 0) list->slots[kept++] = slot;
+        }
+        list->count = kept;
+    }
+}
+
+void range_index_clear() {
+    free(gpa_index);
+    free(age_index);
+    gpa_index = NULL;
+    age_index = NULL;
+    range_index_capacity = 0;
+    range_index_count = 0;
+    for (int c = 0; c < course_postings_count; c++) free(course_postings[c].slots);
+    free(course_postings);
+    course_postings = NULL;
+    course_postings_count = 0;
+    range_index_stale = 1;
+}
+
+// First entry of gpa_index with a GPA above value, or at least value
+// unless above is set
+static int gpa_bound(float value, int above) {
+    int lo = 0, hi = range_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        float gpa = student_gpas[gpa_index[mid]];
+        if (gpa < value || (above && gpa == value)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static int age_bound(int value, int above) {
+    int lo = 0, hi = range_index_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int age = student_ages[age_index[mid]];
+        if (age < value || (above && age == value)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Positions of every student matching q, ascending. Returns the count or
+// -1; *matches must be freed.
+int find_range(const RangeQuery *q, int **matches) {
+    *matches = NULL;
+    if (range_index_stale && !range_index_rebuild()) return -1;
+
+    // Candidates: the shortest of the GPA range, the age range and the
+    // course's posting list
+    int first = gpa_bound(q->min_gpa, 0);
+    int end = gpa_bound(q->max_gpa, 1);
+    const int *candidates = gpa_index + first;
+    int candidate_count = end > first ? end - first : 0;
+    int ordered = 0;   // candidates already ascending
+
+    first = age_bound(q->min_age, 0);
+    end = age_bound(q->max_age, 1);
+    if (end - first < candidate_count) {
+        candidates = age_index + first;
+        candidate_count = end > first ? end - first : 0;
+    }
+    if (q->course >= 0) {
+        const PostingList *list = q->course < course_postings_count ? &course_postings[q->course] : NULL;
+        int count = list != NULL ? list->count : 0;
+        if (count < candidate_count) {
+            candidates = list != NULL ? list->slots : NULL;
+            candidate_count = count;
+            ordered = 1;
+        }
+    }
+
+    int *out = (int *)malloc((candidate_count > 0 ? candidate_count : 1) * sizeof(int));
+    if (out == NULL) return -1;
+    int found = 0;
+    for (int c = 0; c < candidate_count; c++) {
+        int slot = candidates[c];
+        if (q->course >= 0 && student_course_ids[slot] != q->course) continue;
+        if (student_gpas[slot] < q->min_gpa || student_gpas[slot] > q->max_gpa) continue;
+        if (student_ages[slot] < q->min_age || student_ages[slot] > q->max_age) continue;
+        out[found++] = slot;
+    }
+    if (!ordered && found > 1) qsort(out, found, sizeof(int), slot_compare);
+    *matches = out;
+    return found;
+}
+
+// Core Functions
+void initialize_list() {
+    if (!resize_columns(INITIAL_CAPACITY)) {
+        perror("Error allocating initial memory");
+        exit(EXIT_FAILURE);
+    }
+    printf("System initialized with capacity for %d students.\n", student_capacity);
+}
+
+// Resize the columns using realloc once no position is free
+void check_and_resize() {
+    if (free_count == 0 && student_slots >= student_capacity) {
+        if (!resize_columns(student_capacity * 2)) {
+            perror("Error reallocating memory");
+            printf("Memory resize failed. Current student count: %d\n", student_count);
+        } else {
+            printf("Memory successfully resized to capacity: %d\n", student_capacity);
+        }
+    }
+}
+
+float calculate_gpa(float grades[]) {
+    float sum = 0;
+    for (int i = 0; i < MAX_GRADES; i++) {
+        sum += grades[i];
+    }
+    return sum / MAX_GRADES;
+}
+
+int get_unique_id() {
+    int id;
+    int is_unique;
+    do {
+        is_unique = 1;
+        printf("Enter Student ID: ");
+        if (scanf("%d", &id) != 1) {
+            printf("Invalid input. Please enter a number.\n");
+            while (getchar() != '\n');
+            continue;
+        }
+        if (find_student(id) >= 0) {
+            printf("Error: ID %d already exists. Please enter a unique ID.\n", id);
+            is_unique = 0;
+        }
+    } while (!is_unique);
+    return id;
+}
+
+// CRUD Operations 
+
+void add_student() {
+    check_and_resize();
+    
+    Student record;
+    Student *new_student = &record;
+    
+    // Get ID 
+    new_student->id = get_unique_id();
+
+    // Get Name
+    printf("Enter Name: ");
+    while (getchar() != '\n'); 
+    fgets(new_student->name, 50, stdin);
+    new_student->name[strcspn(new_student->name, "\n")] = 0; 
+
+    // Get Age
+    do {
+        printf("Enter Age (18-99): ");
+        if (scanf("%d", &new_student->age) != 1 || new_student->age < 18 || new_student->age > 99) {
+            printf("Invalid age entered.\n");
+            while (getchar() != '\n');
+        } else {
+            break;
+        }
+    } while (1);
+
+    // Get Course
+    printf("Enter Course: ");
+    while (getchar() != '\n');
+    fgets(new_student->course, 50, stdin);
+    new_student->course[strcspn(new_student->course, "\n")] = 0;
+
+    // Get Grades
+    printf("Enter %d Grades (0.0 - 4.0):\n", MAX_GRADES);
+    for (int i = 0; i < MAX_GRADES; i++) {
+        do {
+            printf("  Grade %d: ", i + 1);
+            if (scanf("%f", &new_student->grades[i]) != 1 || !(new_student->grades[i] >= 0.0 && new_student->grades[i] <= 4.0)) {
+                printf("Invalid grade. Must be between 0.0 and 4.0.\n");
+                while (getchar() != '\n');
+            } else {
+                break;
+            }
+        } while (1);
+    }
+
+    // Calculate GPA
+    new_student->gpa = calculate_gpa(new_student->grades);
+    
+    int slot = insert_student(new_student);
+    if (slot < 0) {
+        printf("Error: Not enough memory to add the student.\n");
+        return;
+    }
+    wal_log_student(slot);
+    printf("\nStudent %s added successfully (GPA: %.2f).\n", new_student->name, new_student->gpa);
+}
+
+void display_students() {
+    if (student_count == 0) {
+        printf("\n-- No records to display. --\n");
+        return;
+    }
+    
+    printf("\n--- Student Records (%d/%d) ---\n", student_count, student_capacity);
+    printf("ID | Name            | Age | Course         | Grades (%.1f avg) | GPA\n", (float)MAX_GRADES);
+    printf("------------------------------------------------------------------------\n");
+    int end = display_order_active ? display_order_count : student_slots;
+    for (int k = 0; k < end; k++) {
+        int slot = display_order_active ? display_order[k] : k;
+        if (slot < 0 || !student_live[slot]) continue;
+        Student s;
+        get_student(slot, &s);
+        printf("%-3d| %-15s | %-3d | %-14s | ", 
+            s.id, 
+            s.name, 
+            s.age, 
+            s.course);
+        
+        for (int j = 0; j < MAX_GRADES; j++) {
+            printf("%.1f ", s.grades[j]);
+        }
+        printf("| %.2f\n", s.gpa);
+    }
+    printf("------------------------------------------------------------------------\n");
+}
+
+void delete_student() {
+    if (student_count == 0) {
+        printf("No students to delete.\n");
+        return;
+    }
+
+    int id_to_delete;
+    printf("Enter ID of student to delete: ");
+    if (scanf("%d", &id_to_delete) != 1) {
+        printf("Invalid input.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    int i = find_student(id_to_delete);
+    if (i < 0) {
+        printf("Error: Student with ID %d not found.\n", id_to_delete);
+        return;
+    }
+    remove_student(i);
+    wal_log(WAL_DELETE, &id_to_delete, sizeof(id_to_delete));
+    printf("Student with ID %d deleted.\n", id_to_delete);
+}
+
+
+void update_student() {
+    if (student_count == 0) {
+        printf("No student records available to update.\n");
+        return;
+    }
+
+    int id_to_update;
+    printf("\n--- Update Student Record ---\n");
+    printf("Enter ID of student to update: ");
+    if (scanf("%d", &id_to_update) != 1) {
+        printf("Invalid input.\n");
+        while (getchar() != '\n'); // Clear buffer
+        return;
+    }
+
+    // Search for the student
+    int index = find_student(id_to_update);
+
+    if (index == -1) {
+        printf("Error: Student with ID %d not found.\n", id_to_update);
+        return;
+    }
+
+    // Work on a copy of the record; it is stored back at the end
+    Student record;
+    get_student(index, &record);
+    Student *s = &record;
+    Student before = record;
+    
+    printf("Student Found: %s (Current GPA: %.2f)\n", s->name, s->gpa);
+    printf("What would you like to update?\n");
+    printf("1. Name\n");
+    printf("2. Age\n");
+    printf("3. Course\n");
+    printf("4. Grades (Recalculates GPA)\n");
+    printf("0. Cancel\n");
+    printf("Enter choice: ");
+
+    int choice;
+    if (scanf("%d", &choice) != 1) {
+        printf("Invalid choice.\n");
+        while (getchar() != '\n');
+        return;
+    }
+
+    while (getchar() != '\n'); 
+
+    switch (choice) {
+        case 1: // Update Name
+            printf("Enter New Name: ");
+            fgets(s->name, 50, stdin);
+            s->name[strcspn(s->name, "\n")] = 0; 
+            break;
+
+        case 2: // Update Age
+            printf("Enter New Age: ");
+            int new_age;
+            if (scanf("%d", &new_age) == 1 && new_age >= 18 && new_age <= 99) {
+                s->age = new_age;
+            } else {
+                printf("Invalid age input. Update failed.\n");
+                return;
+            }
+            break;
+
+        case 3: // Update Course
+            printf("Enter New Course: ");
+            fgets(s->course, 50, stdin);
+            s->course[strcspn(s->course, "\n")] = 0;
+            break;
+
+        case 4: // Update Grades
+            printf("Enter %d New Grades (0.0 - 4.0):\n", MAX_GRADES);
+            for (int i = 0; i < MAX_GRADES; i++) {
+                do {
+                    printf("  Grade %d: ", i + 1);
+                    if (scanf("%f", &s->grades[i]) != 1 || !(s->grades[i] >= 0.0 && s->grades[i] <= 4.0)) {
+                        printf("Invalid grade. Try again.\n");
+                        while (getchar() != '\n');
+                    } else {
+                        break;
+                    }
+                } while (1);
+            }
+            
+	    // Recalculate GPA after changing grades
+            s->gpa = calculate_gpa(s->grades);
+            break;
+
+        case 0:
+            printf("Update cancelled.\n");
+            return;
+
+        default:
+            printf("Invalid selection.\n");
+            return;
+    }
+
+    // An unchanged record is neither stored nor logged
+    if (strcmp(s->name, before.name) != 0 || s->age != before.age ||
+        strcmp(s->course, before.course) != 0 ||
+        memcmp(s->grades, before.grades, sizeof(s->grades)) != 0) {
+        if (!put_student(index, s)) {
+            printf("Error: Not enough memory to store the update.\n");
+            return;
+        }
+        if (strcmp(s->name, before.name) != 0) name_index_invalidate();
+        wal_log_student(index);
+    }
+
+    switch (choice) {
+        case 1: printf("Name updated successfully.\n"); break;
+        case 2: printf("Age updated successfully.\n"); break;
+        case 3: printf("Course updated successfully.\n"); break;
+        case 4: printf("Grades updated. New GPA is %.2f.\n", s->gpa); break;
+    }
+}
+
+// Search and Sorting Algorithms
+void search_records() {
+    int choice;
+    printf("Search by: 1. ID | 2. Name | 3. Name prefix | 4. Name contains | 5. Course, GPA and age: ");
+    if (scanf("%d", &choice) != 1) {
+        printf("Invalid choice.\n");
+        return;
+    }
+    
+    if (choice == 1) {
+        int id_search;
+        printf("Enter ID to search: ");
+        if (scanf("%d", &id_search) != 1) {
+            printf("Invalid input.\n");
+            return;
+        }
+        
+        // Hash index lookup
+        int i = find_student(id_search);
+        if (i >= 0) {
+            printf("\n--- Found Student ---\n");
+            printf("ID: %d, Name: %s, GPA: %.2f\n", 
+                   student_ids[i], student_name(i), student_gpas[i]);
+            return;
+        }
+        printf("Student with ID %d not found.\n", id_search);
+
+    } else if (choice >= 2 && choice <= 4) {
+        char name_search[50];
+        printf("Enter Name to search: ");
+        while (getchar() != '\n');
+        if (fgets(name_search, 50, stdin) == NULL) return;
+        name_search[strcspn(name_search, "\n")] = 0;
+        if (name_search[0] == '\0') {
+            printf("Invalid input.\n");
+            return;
+        }
+
+        int first = 0;
+        int *matches = NULL;
+        int count;
+        if (choice == 4) {
+            count = find_name_substring(name_search, &matches);
+        } else {
+            count = find_name_prefix(name_search, &first);
+        }
+        if (count < 0) {
+            printf("Error: Not enough memory to search.\n");
+            return;
+        }
+
+        // Exact search keeps the prefix matches of the same length
+        int found = 0;
+        for (int m = 0; m < count; m++) {
+            int i = matches != NULL ? matches[m] : name_index[first + m];
+            if (!student_live[i]) continue;
+            if (choice == 2 && strcasecmp(student_name(i), name_search) != 0) continue;
+            if (found == 0) printf("\n--- Found Students ---\n");
+            if (++found > MAX_PRINTED_MATCHES) continue;
+            printf("ID: %d, Name: %s, GPA: %.2f\n", 
+                   student_ids[i], student_name(i), student_gpas[i]);
+        }
+        free(matches);
+
+        if (found == 0) {
+            printf("Student with name '%s' not found.\n", name_search);
+        } else if (found > MAX_PRINTED_MATCHES) {
+            printf("... and %d more (%d matches).\n", found - MAX_PRINTED_MATCHES, found);
+        }
+
+    } else if (choice == 5) {
+        RangeQuery q = { -1, -FLT_MAX, FLT_MAX, INT_MIN, INT_MAX };
+        char line[50];
+        while (getchar() != '\n');
+        printf("Enter Course (blank for any): ");
+        if (fgets(line, sizeof(line), stdin) == NULL) return;
+        line[strcspn(line, "\n")] = 0;
+        if (line[0] != '\0' && (q.course = course_lookup(line)) < 0) {
+            printf("No students found.\n");
+            return;
+        }
+        printf("Enter GPA range as MIN MAX (blank for any): ");
+        if (fgets(line, sizeof(line), stdin) == NULL) return;
+        if (line[strspn(line, " \t\n")] != '\0' && sscanf(line, "%f %f", &q.min_gpa, &q.max_gpa) != 2) {
+            printf("Invalid input.\n");
+            return;
+        }
+        printf("Enter Age range as MIN MAX (blank for any): ");
+        if (fgets(line, sizeof(line), stdin) == NULL) return;
+        if (line[strspn(line, " \t\n")] != '\0' && sscanf(line, "%d %d", &q.min_age, &q.max_age) != 2) {
+            printf("Invalid input.\n");
+            return;
+        }
+
+        int *matches = NULL;
+        int found = find_range(&q, &matches);
+        if (found < 0) {
+            printf("Error: Not enough memory to search.\n");
+            return;
+        }
+        for (int m = 0; m < found && m < MAX_PRINTED_MATCHES; m++) {
+            int i = matches[m];
+            if (m == 0) printf("\n--- Found Students ---\n");
+            printf("ID: %d, Name: %s, Age: %d, Course: %s, GPA: %.2f\n",
+                   student_ids[i], student_name(i), student_ages[i], student_course(i), student_gpas[i]);
+        }
+        free(matches);
+
+        if (found == 0) {
+            printf("No students found.\n");
+        } else if (found > MAX_PRINTED_MATCHES) {
+            printf("... and %d more (%d matches).\n", found - MAX_PRINTED_MATCHES, found);
+        }
+    }
+}
+
+// Sort Engine
+// Sorting never moves Student records. Each sort key becomes a column of
+// order-preserving 32-bit values (strings are replaced by the rank of their
+// distinct value), and (key, position) pairs taken in the current display
+// order are radix sorted on two columns per pass, last keys first. Every
+// pass is stable, so the result is a stable multi-key sort in O(n) passes
+// plus O(d log d) to rank d distinct strings.
+
+// Drops the deleted entries from the display order, renumbering the rest
+// through new_slot if given, and rebuilds display_rank. display_rank must
+// already hold student_slots entries.
+static void display_order_squeeze(const int *new_slot) {
+    int kept = 0;
+    for (int k = 0; k < display_order_count; k++) {
+        int slot = display_order[k];
+        if (slot < 0) continue;
+        if (new_slot != NULL) slot = new_slot[slot];
+        display_order[kept] = slot;
+        display_rank[slot] = kept++;
+    }
+    display_order_count = kept;
+}
+
+// Keeps the display order in step with a student added at slot: it is
+// shown last, as in storage order
+void display_order_add(int slot) {
+    if (!display_order_active) return;
+    if (display_order_count == display_order_capacity &&
+        display_order_count - student_count >= display_order_count / 2) {
+        // Mostly deleted entries: reclaim them instead of growing
+        display_order_squeeze(NULL);
+    }
+    if (display_order_count == display_order_capacity) {
+        int capacity = display_order_capacity > 0 ? display_order_capacity * 2 : INITIAL_CAPACITY;
+        int *temp = (int *)realloc(display_order, capacity * sizeof(int));
+        if (temp == NULL) {
+            // Fall back to storage order rather than lose the record
+            display_order_active = 0;
+            return;
+        }
+        display_order = temp;
+        display_order_capacity = capacity;
+    }
+    if (slot >= display_rank_capacity) {
+        int *temp = (int *)realloc(display_rank, student_capacity * sizeof(int));
+        if (temp == NULL) {
+            display_order_active = 0;
+            return;
+        }
+        display_rank = temp;
+        display_rank_capacity = student_capacity;
+    }
+    display_rank[slot] = display_order_count;
+    display_order[display_order_count++] = slot;
+}
+
+// Leaves a hole where the student deleted from slot was shown
+void display_order_remove(int slot) {
+    if (!display_order_active) return;
+    display_order[display_rank[slot]] = -1;
+}
+
+// Renumbers the display order after a compaction
+void display_order_remap(const int *new_slot) {
+    if (!display_order_active) return;
+    display_order_squeeze(new_slot);
+}
+
+// Order-preserving 32-bit images of the numeric fields
+static uint32_t int_key(int value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static uint32_t float_key(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// First eight bytes of a string, big-endian, so they compare like strcmp
+static uint64_t string_prefix_key(const char *s) {
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && s[i] != '\0'; i++) key = (key << 8) | (unsigned char)s[i];
+    return i == 0 ? 0 : key << (8 * (8 - i));
+}
+
+// Stable LSD radix sort on the 64-bit keys, one byte per pass. Passes
+// where every key has the same byte are skipped.
+static void radix_sort_pairs(SortPair *pairs, SortPair *tmp, int n) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        int counts[256] = { 0 };
+        for (int i = 0; i < n; i++) counts[(pairs[i].key >> shift) & 0xFF]++;
+        if (counts[(pairs[0].key >> shift) & 0xFF] == n) continue;
+
+        int offsets[256];
+        for (int b = 0, total = 0; b < 256; b++) {
+            offsets[b] = total;
+            total += counts[b];
+        }
+        for (int i = 0; i < n; i++) tmp[offsets[(pairs[i].key >> shift) & 0xFF]++] = pairs[i];
+        memcpy(pairs, tmp, n * sizeof(SortPair));
+    }
+}
+
+// Bottom-up merge sort of pairs whose keys are prefixes of string_of(index);
+// equal prefixes fall back to strcmp. Returns the buffer holding the result.
+static SortPair *merge_sort_strings(SortPair *pairs, SortPair *tmp, int n,
+                                    const char *(*string_of)(int)) {
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int i = lo, j = mid, out = lo;
+            while (i < mid && j < hi) {
+                int cmp = (pairs[j].key > pairs[i].key) - (pairs[j].key < pairs[i].key);
+                if (cmp == 0 && (pairs[i].key & 0xFF) != 0) {
+                    cmp = strcmp(string_of(pairs[j].index), string_of(pairs[i].index));
+                }
+                // Take from the right run only when strictly smaller
+                if (cmp < 0) tmp[out++] = pairs[j++];
+                else tmp[out++] = pairs[i++];
+            }
+            while (i < mid) tmp[out++] = pairs[i++];
+            while (j < hi) tmp[out++] = pairs[j++];
+        }
+        SortPair *swap = pairs;
+        pairs = tmp;
+        tmp = swap;
+    }
+    return pairs;
+}
+
+// Replaces each student's name with the rank of its value among the
+// distinct names: equal names are found with a hash table, and only the
+// distinct ones are sorted. Returns 0 if out of memory.
+static int name_ranks(uint32_t *out) {
+    int table_size = 16;
+    while (table_size < 2 * student_count) table_size *= 2;
+    int *table = (int *)malloc(table_size * sizeof(int));
+    int *first_slot = (int *)malloc((student_count + 1) * sizeof(int));
+    SortPair *pairs = (SortPair *)malloc((student_count + 1) * sizeof(SortPair));
+    SortPair *tmp = (SortPair *)malloc((student_count + 1) * sizeof(SortPair));
+    if (table == NULL || first_slot == NULL || pairs == NULL || tmp == NULL) {
+        free(table);
+        free(first_slot);
+        free(pairs);
+        free(tmp);
+        return 0;
+    }
+
+    // Distinct values, numbered in order of first appearance
+    int distinct = 0;
+    memset(table, -1, table_size * sizeof(int));
+    for (int i = 0; i < student_slots; i++) {
+        if (!student_live[i]) continue;
+        const char *value = student_name(i);
+        unsigned int mask = table_size - 1;
+        unsigned int h = string_hash(value) & mask;
+        while (table[h] >= 0 &&
+               strcmp(student_name(first_slot[table[h]]), value) != 0) {
+            h = (h + 1) & mask;
+        }
+        if (table[h] < 0) {
+            table[h] = distinct;
+            first_slot[distinct++] = i;
+        }
+        out[i] = table[h];
+    }
+
+    for (int d = 0; d < distinct; d++) {
+        pairs[d].key = string_prefix_key(student_name(first_slot[d]));
+        pairs[d].index = first_slot[d];
+    }
+    SortPair *sorted = merge_sort_strings(pairs, tmp, distinct, student_name);
+
+    // table is reused to map a distinct number to its rank
+    for (int r = 0; r < distinct; r++) table[out[sorted[r].index]] = r;
+    for (int i = 0; i < student_slots; i++) {
+        if (student_live[i]) out[i] = table[out[i]];
+    }
+
+    free(table);
+    free(first_slot);
+    free(pairs);
+    free(tmp);
+    return 1;
+}
+
+static const char *course_name(int id) {
+    return courses[id].name;
+}
+
+// Replaces each student's course with the rank of its name: only the
+// dictionary is sorted. Returns 0 if out of memory.
+static int course_ranks(uint32_t *out) {
+    SortPair *pairs = (SortPair *)malloc((course_count + 1) * sizeof(SortPair));
+    SortPair *tmp = (SortPair *)malloc((course_count + 1) * sizeof(SortPair));
+    uint32_t *rank = (uint32_t *)malloc((course_count + 1) * sizeof(uint32_t));
+    if (pairs == NULL || tmp == NULL || rank == NULL) {
+        free(pairs);
+        free(tmp);
+        free(rank);
+        return 0;
+    }
+
+    for (int c = 0; c < course_count; c++) {
+        pairs[c].key = string_prefix_key(courses[c].name);
+        pairs[c].index = c;
+    }
+    SortPair *sorted = merge_sort_strings(pairs, tmp, course_count, course_name);
+    for (int r = 0; r < course_count; r++) rank[sorted[r].index] = r;
+    for (int i = 0; i < student_slots; i++) {
+        if (student_live[i]) out[i] = rank[student_course_ids[i]];
+    }
+
+    free(pairs);
+    free(tmp);
+    free(rank);
+    return 1;
+}
+
+// Order-preserving key of one sort key for every position (meaningless
+// at deleted ones). Returns 0 if out of memory.
+static int sort_column(const SortKey *key, uint32_t *out) {
+    if (key->field == FIELD_NAME) {
+        if (!name_ranks(out)) return 0;
+    } else if (key->field == FIELD_COURSE) {
+        if (!course_ranks(out)) return 0;
+    } else if (key->field == FIELD_GPA) {
+        for (int i = 0; i < student_slots; i++) out[i] = float_key(student_gpas[i]);
+    } else {
+        const int *column = key->field == FIELD_ID ? student_ids : student_ages;
+        for (int i = 0; i < student_slots; i++) out[i] = int_key(column[i]);
+    }
+    if (key->descending) {
+        for (int i = 0; i < student_slots; i++) out[i] = ~out[i];
+    }
+    return 1;
+}
+
+// Rewrites the display order according to spec. Returns 0 if out of memory.
+int sort_students(const SortSpec *spec) {
+    if (display_order_capacity < student_count) {
+        int *order = (int *)realloc(display_order, student_count * sizeof(int));
+        if (order == NULL) return 0;
+        display_order = order;
+        display_order_capacity = student_count;
+    }
+    if (display_rank_capacity < student_capacity) {
+        int *rank = (int *)realloc(display_rank, student_capacity * sizeof(int));
+        if (rank == NULL) return 0;
+        display_rank = rank;
+        display_rank_capacity = student_capacity;
+    }
+    SortPair *pairs = (SortPair *)malloc(student_count * sizeof(SortPair));
+    SortPair *tmp = (SortPair *)malloc(student_count * sizeof(SortPair));
+    uint32_t *major = (uint32_t *)malloc(student_slots * sizeof(uint32_t));
+    uint32_t *minor = (uint32_t *)malloc(student_slots * sizeof(uint32_t));
+    int ok = pairs != NULL && tmp != NULL && major != NULL && minor != NULL;
+
+    // Live students in their current display order
+    int n = 0;
+    int end = display_order_active ? display_order_count : student_slots;
+    for (int k = 0; ok && k < end; k++) {
+        int slot = display_order_active ? display_order[k] : k;
+        if (slot >= 0 && student_live[slot]) pairs[n++].index = slot;
+    }
+    // Least significant keys first, two per pass
+    for (int k = spec->count - 1; ok && k >= 0; k -= 2) {
+        ok = sort_column(&spec->keys[k], minor) &&
+             (k == 0 || sort_column(&spec->keys[k - 1], major));
+        if (!ok) break;
+        for (int j = 0; j < n; j++) {
+            int i = pairs[j].index;
+            pairs[j].key = ((k > 0 ? (uint64_t)major[i] : 0) << 32) | minor[i];
+        }
+        radix_sort_pairs(pairs, tmp, n);
+    }
+
+    if (ok) {
+        for (int k = 0; k < n; k++) {
+            display_order[k] = pairs[k].index;
+            display_rank[pairs[k].index] = k;
+        }
+        display_order_count = n;
+        display_order_active = 1;
+    }
+    free(pairs);
+    free(tmp);
+    free(major);
+    free(minor);
+    return ok;
+}
+
+static const char *field_names[] = { "id", "name", "age", "course", "gpa" };
+
+// Parses keys such as "course gpa- name": a field name, optionally
+// followed by - for descending or + for ascending. Returns 0 on error.
+static int parse_sort_spec(char *text, SortSpec *spec) {
+    spec->count = 0;
+    for (char *token = strtok(text, " \t\n,"); token != NULL; token = strtok(NULL, " \t\n,")) {
+        size_t length = strlen(token);
+        int descending = 0;
+        if (length > 1 && (token[length - 1] == '-' || token[length - 1] == '+')) {
+            descending = token[length - 1] == '-';
+            token[--length] = '\0';
+        }
+
+        int field = -1;
+        for (int f = 0; f < (int)(sizeof(field_names) / sizeof(field_names[0])); f++) {
+            if (strcasecmp(token, field_names[f]) == 0) field = f;
+        }
+        if (field < 0 || spec->count == MAX_SORT_KEYS) return 0;
+        spec->keys[spec->count].field = (SortField)field;
+        spec->keys[spec->count].descending = descending;
+        spec->count++;
+    }
+    return spec->count > 0;
+}
+
+void sort_records() {
+    if (student_count < 2) {
+        printf("Need at least 2 students to sort.\n");
+        return;
+    }
+    
+    int choice;
+    printf("Sort by: 1. GPA | 2. ID | 3. Name | 4. Custom keys: ");
+    if (scanf("%d", &choice) != 1) {
+        printf("Invalid input.\n");
+        while(getchar() != '\n');
+        return;
+    }
+
+    SortSpec spec = { 1, { { FIELD_GPA, 1 } } };   // GPA, highest first
+    if (choice == 2) {
+        spec.keys[0].field = FIELD_ID;
+        spec.keys[0].descending = 0;
+    } else if (choice == 3) {
+        spec.keys[0].field = FIELD_NAME;
+        spec.keys[0].descending = 0;
+    } else if (choice == 4) {
+        char text[128];
+        printf("Enter keys in order, '-' for descending (e.g. course gpa- name): ");
+        while (getchar() != '\n');
+        if (fgets(text, sizeof(text), stdin) == NULL || !parse_sort_spec(text, &spec)) {
+            printf("Invalid keys. Fields: id, name, age, course, gpa (at most %d).\n", MAX_SORT_KEYS);
+            return;
+        }
+    } else if (choice != 1) {
+        printf("Invalid choice.\n");
+        return;
+    }
+
+    if (!sort_students(&spec)) {
+        printf("Error: Not enough memory to sort.\n");
+        return;
+    }
+
+    printf("Records sorted by ");
+    if (choice == 1) printf("GPA (highest first).\n");
+    else if (choice == 2) printf("ID (ascending).\n");
+    else if (choice == 3) printf("Name (A-Z).\n");
+    else {
+        for (int k = 0; k < spec.count; k++) {
+            printf("%s%s%s", k > 0 ? ", then " : "", field_names[spec.keys[k].field],
+                   spec.keys[k].descending ? " (descending)" : "");
+        }
+        printf(".\n");
+    }
+}
+
+// Statistical and Analytical Features
+// generate_reports makes one pass over the roster. Each thread aggregates
+// a contiguous slice into its own array of course groups, indexed by
+// course number; the arrays are then merged in slice order, so ties
+// resolve to the earliest record exactly as a serial scan would.
+
+static int report_partial_init(ReportPartial *partial, int from, int to) {
+    memset(partial, 0, sizeof(*partial));
+    partial->from = from;
+    partial->to = to;
+    partial->max_gpa = -1.0f;
+    partial->min_gpa = 5.0f;
+    partial->top_slot = -1;
+    partial->groups = (CourseGroup *)malloc((course_count + 1) * sizeof(CourseGroup));
+    if (partial->groups == NULL) return 0;
+    for (int c = 0; c < course_count; c++) {
+        CourseGroup *g = &partial->groups[c];
+        memset(g, 0, sizeof(*g));
+        g->max_gpa = -1.0f;
+        g->top_slot = -1;
+    }
+    return 1;
+}
+
+// Thread body: aggregates the partial's slice of the roster. Only the GPA,
+// course number and live columns are read.
+static void *report_scan(void *arg) {
+    ReportPartial *partial = (ReportPartial *)arg;
+    double gpa_sum = 0;
+    float max_gpa = partial->max_gpa, min_gpa = partial->min_gpa;
+    for (int i = partial->from; i < partial->to; i++) {
+        if (!student_live[i]) continue;
+        float gpa = student_gpas[i];
+        gpa_sum += gpa;
+        if (gpa > max_gpa) {
+            max_gpa = gpa;
+            partial->top_slot = i;
+        }
+        if (gpa < min_gpa) min_gpa = gpa;
+    }
+    partial->gpa_sum = gpa_sum;
+    partial->max_gpa = max_gpa;
+    partial->min_gpa = min_gpa;
+
+    for (int i = partial->from; i < partial->to; i++) {
+        if (!student_live[i]) continue;
+        CourseGroup *g = &partial->groups[student_course_ids[i]];
+        float gpa = student_gpas[i];
+        if (g->count++ == 0) g->first_slot = i;
+        g->gpa_sum += gpa;
+        if (gpa > g->max_gpa) {
+            g->max_gpa = gpa;
+            g->top_slot = i;
+        }
+    }
+    return NULL;
+}
+
+// Folds src, which covers records after dst's, into dst
+static void report_merge(ReportPartial *dst, const ReportPartial *src) {
+    dst->gpa_sum += src->gpa_sum;
+    if (src->max_gpa > dst->max_gpa) {
+        dst->max_gpa = src->max_gpa;
+        dst->top_slot = src->top_slot;
+    }
+    if (src->min_gpa < dst->min_gpa) dst->min_gpa = src->min_gpa;
+
+    for (int c = 0; c < course_count; c++) {
+        const CourseGroup *from = &src->groups[c];
+        CourseGroup *g = &dst->groups[c];
+        if (from->count == 0) continue;
+        if (g->count == 0) g->first_slot = from->first_slot;
+        g->count += from->count;
+        g->gpa_sum += from->gpa_sum;
+        if (from->max_gpa > g->max_gpa) {
+            g->max_gpa = from->max_gpa;
+            g->top_slot = from->top_slot;
+        }
+    }
+}
+
+static const CourseGroup *report_groups;
+
+static int compare_first_slot(const void *a, const void *b) {
+    int slot_a = report_groups[*(const int *)a].first_slot;
+    int slot_b = report_groups[*(const int *)b].first_slot;
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+// Aggregates the whole roster into report, across threads for large ones.
+// Returns 0 if out of memory; otherwise report->groups must be freed.
+static int report_aggregate(ReportPartial *report) {
+    int threads = 1;
+    if (student_count >= REPORT_PARALLEL_MIN) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores < 1 ? 1 : (cores > MAX_REPORT_THREADS ? MAX_REPORT_THREADS : (int)cores);
+    }
+
+    ReportPartial partials[MAX_REPORT_THREADS];
+    pthread_t workers[MAX_REPORT_THREADS];
+    int started[MAX_REPORT_THREADS] = { 0 };
+    int ok = 1;
+    for (int t = 0; t < threads; t++) {
+        ok = report_partial_init(&partials[t], (int)((long long)student_slots * t / threads),
+                                 (int)((long long)student_slots * (t + 1) / threads)) && ok;
+    }
+    if (!ok) {
+        for (int t = 0; t < threads; t++) free(partials[t].groups);
+        return 0;
+    }
+
+    // The calling thread takes the first slice; a worker that fails to
+    // start has its slice run here too
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, report_scan, &partials[t]) == 0;
+    }
+    report_scan(&partials[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(workers[t], NULL);
+        else report_scan(&partials[t]);
+    }
+
+    *report = partials[0];
+    for (int t = 1; t < threads; t++) {
+        report_merge(report, &partials[t]);
+        free(partials[t].groups);
+    }
+    return 1;
+}
+
+// Report Totals
+
+static void group_reset(CourseGroup *g) {
+    memset(g, 0, sizeof(*g));
+    g->max_gpa = -1.0f;
+    g->top_slot = -1;
+}
+
+// Counts the student at slot into g. Ties for the top go to the earliest
+// position, as in a scan.
+static void group_add(CourseGroup *g, int slot, float gpa) {
+    g->count++;
+    g->gpa_sum += gpa;
+    if (g->stale) return;
+    if (g->count == 1 || slot < g->first_slot) g->first_slot = slot;
+    if (gpa > g->max_gpa || (gpa == g->max_gpa && slot < g->top_slot)) {
+        g->max_gpa = gpa;
+        g->top_slot = slot;
+    }
+}
+
+static void group_remove(CourseGroup *g, int slot, float gpa) {
+    if (--g->count == 0) {
+        group_reset(g);
+        return;
+    }
+    g->gpa_sum -= gpa;
+    if (slot == g->first_slot || slot == g->top_slot) g->stale = 1;
+}
+
+void report_totals_invalidate() {
+    report_totals_stale = 1;
+}
+
+// Counts the student just stored at slot into the totals
+void report_totals_add(int slot) {
+    if (report_totals_stale) return;
+    int course = student_course_ids[slot];
+    if (course >= report_course_capacity) {
+        int capacity = report_course_capacity > 0 ? report_course_capacity * 2 : 16;
+        if (capacity <= course) capacity = course + 1;
+        CourseGroup *temp = (CourseGroup *)realloc(report_courses, capacity * sizeof(CourseGroup));
+        if (temp == NULL) {
+            report_totals_stale = 1;
+            return;
+        }
+        report_courses = temp;
+        for (int c = report_course_capacity; c < capacity; c++) group_reset(&report_courses[c]);
+        report_course_capacity = capacity;
+    }
+
+    float gpa = student_gpas[slot];
+    if (report_class.count == 0) report_min_gpa = gpa;
+    else if (gpa < report_min_gpa) report_min_gpa = gpa;
+    group_add(&report_class, slot, gpa);
+    group_add(&report_courses[course], slot, gpa);
+}
+
+// Takes the student at slot, whose record is still in place, out of the
+// totals before it is deleted or overwritten
+void report_totals_forget(int slot) {
+    if (report_totals_stale) return;
+    float gpa = student_gpas[slot];
+    if (gpa <= report_min_gpa) report_class.stale = 1;
+    group_remove(&report_class, slot, gpa);
+    group_remove(&report_courses[student_course_ids[slot]], slot, gpa);
+}
+
+// Renumbers the positions held by the totals after a compaction, which
+// keeps positions in order and so every tie
+void report_totals_remap(const int *new_slot) {
+    if (report_totals_stale) return;
+    if (report_class.top_slot >= 0) report_class.top_slot = new_slot[report_class.top_slot];
+    for (int c = 0; c < report_course_capacity; c++) {
+        CourseGroup *g = &report_courses[c];
+        if (g->count == 0 || g->stale) continue;
+        g->first_slot = new_slot[g->first_slot];
+        g->top_slot = new_slot[g->top_slot];
+    }
+}
+
+// Recomputes the first and best student of every stale group. With the
+// range index in place only the students concerned are visited.
+static void report_rescan(void) {
+    int stale_courses = 0;
+    for (int c = 0; c < report_course_capacity; c++) stale_courses += report_courses[c].stale;
+    if (!report_class.stale && stale_courses == 0) return;
+
+    if (!range_index_stale) {
+        if (report_class.stale) {
+            report_min_gpa = student_gpas[gpa_index[0]];
+            report_class.max_gpa = student_gpas[gpa_index[range_index_count - 1]];
+            report_class.top_slot = gpa_index[gpa_bound(report_class.max_gpa, 0)];
+            report_class.stale = 0;
+        }
+        for (int c = 0; c < report_course_capacity && c < course_postings_count; c++) {
+            CourseGroup *g = &report_courses[c];
+            const PostingList *list = &course_postings[c];
+            if (!g->stale) continue;
+            g->stale = 0;
+            g->max_gpa = -1.0f;
+            g->first_slot = list->slots[0];
+            for (int k = 0; k < list->count; k++) {
+                float gpa = student_gpas[list->slots[k]];
+                if (gpa > g->max_gpa) {
+                    g->max_gpa = gpa;
+                    g->top_slot = list->slots[k];
+                }
+            }
+        }
+        return;
+    }
+
+    int rescan_class = report_class.stale;
+    if (rescan_class) {
+        report_class.max_gpa = -1.0f;
+        report_min_gpa = 5.0f;
+    }
+    for (int c = 0; c < report_course_capacity; c++) {
+        CourseGroup *g = &report_courses[c];
+        if (g->stale) {
+            g->first_slot = -1;
+            g->max_gpa = -1.0f;
+        }
+    }
+    for (int i = 0; i < student_slots; i++) {
+        if (!student_live[i]) continue;
+        float gpa = student_gpas[i];
+        if (rescan_class) {
+            if (gpa > report_class.max_gpa) {
+                report_class.max_gpa = gpa;
+                report_class.top_slot = i;
+            }
+            if (gpa < report_min_gpa) report_min_gpa = gpa;
+        }
+        CourseGroup *g = &report_courses[student_course_ids[i]];
+        if (!g->stale) continue;
+        if (g->first_slot < 0) g->first_slot = i;
+        if (gpa > g->max_gpa) {
+            g->max_gpa = gpa;
+            g->top_slot = i;
+        }
+    }
+    report_class.stale = 0;
+    for (int c = 0; c < report_course_capacity; c++) report_courses[c].stale = 0;
+}
+
+// Brings the totals up to date: a full aggregation if they are stale,
+// else a rescan of the stale groups. Returns 0 if out of memory.
+static int report_refresh(void) {
+    if (report_totals_stale) {
+        ReportPartial report;
+        if (!report_aggregate(&report)) return 0;
+        free(report_courses);
+        report_courses = report.groups;
+        report_course_capacity = course_count;
+
+        group_reset(&report_class);
+        report_class.count = student_count;
+        report_class.gpa_sum = report.gpa_sum;
+        report_class.max_gpa = report.max_gpa;
+        report_class.top_slot = report.top_slot;
+        report_min_gpa = report.min_gpa;
+        report_totals_stale = 0;
+    }
+    report_rescan();
+    return 1;
+}
+
+void generate_reports() {
+    if (student_count == 0) {
+        printf("No student data available for reports.\n");
+        return;
+    }
+
+    int *ordered = (int *)malloc((course_count + 1) * sizeof(int));
+    if (ordered == NULL || !report_refresh()) {
+        free(ordered);
+        printf("Error: Not enough memory to generate reports.\n");
+        return;
+    }
+
+    // --- Part 1: Class-wide Statistics ---
+    printf("-- Performance Report --\n");
+    printf("Total Students:      %d\n", student_count);
+    printf("Overall Average GPA: %.2f\n", report_class.gpa_sum / student_count);
+    if (report_class.top_slot != -1) {
+        printf("Best Student Overall: %s (GPA: %.2f)\n", 
+               student_name(report_class.top_slot), report_class.max_gpa);
+    }
+    printf("Lowest Class GPA:    %.2f\n", report_min_gpa);
+
+
+    // Course Analysis 
+    printf("\n-- Analysis by Course --\n");
+
+    int count = 0;
+    for (int c = 0; c < course_count && c < report_course_capacity; c++) {
+        if (report_courses[c].count > 0) ordered[count++] = c;
+    }
+    report_groups = report_courses;
+    qsort(ordered, count, sizeof(int), compare_first_slot);
+
+    for (int i = 0; i < count; i++) {
+        const CourseGroup *g = &report_courses[ordered[i]];
+        printf("Course: %-15s\n", courses[ordered[i]].name);
+        printf("   - Students Enrolled: %d\n", g->count);
+        printf("   - Average GPA:       %.2f\n", g->gpa_sum / g->count);
+        printf("   - Top Performer:     %s (%.2f)\n",
+               g->top_slot >= 0 ? student_name(g->top_slot) : "N/A", g->max_gpa);
+    }
+    free(ordered);
+}
+
+// Renames a course for every enrolled student at once
+void rename_course() {
+    char old_name[COURSE_NAME_SIZE], new_name[COURSE_NAME_SIZE];
+    printf("Enter Course to rename: ");
+    while (getchar() != '\n');
+    if (fgets(old_name, sizeof(old_name), stdin) == NULL) return;
+    old_name[strcspn(old_name, "\n")] = 0;
+
+    int id = course_lookup(old_name);
+    if (id < 0) {
+        printf("Error: Course '%s' not found.\n", old_name);
+        return;
+    }
+
+    printf("Enter New Course name: ");
+    if (fgets(new_name, sizeof(new_name), stdin) == NULL) return;
+    new_name[strcspn(new_name, "\n")] = 0;
+    if (!course_rename(id, new_name)) {
+        printf("Error: Course '%s' already exists.\n", new_name);
+        return;
+    }
+    wal_log_rename(old_name, new_name);
+    printf("Course '%s' renamed to '%s' (%d students).\n", old_name, new_name, courses[id].enrolled);
+}
+
+// Bulk Import and Export
+// Rows are id,name,age,course,grade1,grade2,grade3 with an optional
+// trailing GPA, which is recalculated rather than read. Fields holding a
+// comma or quote are quoted, with quotes doubled. import_csv maps the file
+// and parses it in place across threads; the rows are then inserted in
+// file order after a single reservation of column space.
+
+static const char IMPORT_BAD_ID[] = "ID must be a whole number";
+
+// Copies the CSV field at *p into out (at most size - 1 bytes and a NUL),
+// undoing quoting, and moves *p past it and its comma. Returns 1 if
+// another field follows, 0 if it was the last on the line and -1 if it is
+// too long or badly quoted.
+static int csv_field(const char **p, const char *end, char *out, size_t size) {
+    const char *s = *p;
+    size_t n = 0;
+    int ok = 1;
+    if (s < end && *s == '"') {
+        for (s++; ; ) {
+            if (s == end) return -1;
+            char c = *s++;
+            if (c == '"') {
+                if (s == end || *s != '"') break;
+                s++;
+            }
+            if (n + 1 < size) out[n++] = c;
+            else ok = 0;
+        }
+        if (s < end && *s != ',') ok = 0;
+    } else {
+        for (; s < end && *s != ','; s++) {
+            if (n + 1 < size) out[n++] = *s;
+            else ok = 0;
+        }
+    }
+    out[n] = '\0';
+    *p = s < end ? s + 1 : s;
+    if (!ok) return -1;
+    return s < end;
+}
+
+static int parse_int(const char *text, int *out) {
+    char *rest;
+    errno = 0;
+    long value = strtol(text, &rest, 10);
+    while (isspace((unsigned char)*rest)) rest++;
+    if (rest == text || *rest != '\0' || errno != 0 || value < INT_MIN || value > INT_MAX) return 0;
+    *out = (int)value;
+    return 1;
+}
+
+static int parse_float(const char *text, float *out) {
+    char *rest;
+    float value = strtof(text, &rest);
+    while (isspace((unsigned char)*rest)) rest++;
+    // strtof accepts "nan" and "inf", which no range check rejects
+    if (rest == text || *rest != '\0' || !isfinite(value)) return 0;
+    *out = value;
+    return 1;
+}
+
+// Parses the line [p, end) into s, checking it as add_student checks its
+// input. Returns NULL if the line is a valid record, else the reason it
+// is not.
+static const char *parse_csv_line(const char *p, const char *end, Student *s) {
+    char text[32];
+    memset(s, 0, sizeof(*s));
+
+    int more = csv_field(&p, end, text, sizeof(text));
+    if (more < 0 || !parse_int(text, &s->id)) return IMPORT_BAD_ID;
+    if (!more || (more = csv_field(&p, end, s->name, sizeof(s->name))) < 0) {
+        return more < 0 ? "name is too long or badly quoted" : "expected 7 or 8 fields";
+    }
+    if (!more || (more = csv_field(&p, end, text, sizeof(text))) < 0 ||
+        !parse_int(text, &s->age) || s->age < 18 || s->age > 99) {
+        return "age must be a whole number from 18 to 99";
+    }
+    if (!more || (more = csv_field(&p, end, s->course, sizeof(s->course))) < 0) {
+        return more < 0 ? "course is too long or badly quoted" : "expected 7 or 8 fields";
+    }
+    for (int i = 0; i < MAX_GRADES; i++) {
+        if (!more) return "expected 7 or 8 fields";
+        more = csv_field(&p, end, text, sizeof(text));
+        if (more < 0 || !parse_float(text, &s->grades[i]) ||
+            s->grades[i] < 0.0 || s->grades[i] > 4.0) {
+            return "grades must be between 0.0 and 4.0";
+        }
+    }
+    // An exported GPA column is accepted and ignored
+    if (more && csv_field(&p, end, text, sizeof(text)) != 0) return "expected 7 or 8 fields";
+    s->gpa = calculate_gpa(s->grades);
+    return NULL;
+}
+
+static void import_error(ImportChunk *chunk, int line, const char *reason) {
+    if (chunk->error_count < MAX_IMPORT_ERRORS) {
+        chunk->error_lines[chunk->error_count] = line;
+        chunk->error_reasons[chunk->error_count] = reason;
+    }
+    chunk->error_count++;
+}
+
+// Thread body: parses the chunk's lines into its rows
+static void *import_scan(void *arg) {
+    ImportChunk *chunk = (ImportChunk *)arg;
+    const char *p = chunk->begin;
+    while (p < chunk->end) {
+        const char *newline = (const char *)memchr(p, '\n', chunk->limit - p);
+        const char *line_end = newline != NULL ? newline : chunk->limit;
+        const char *next = newline != NULL ? newline + 1 : chunk->limit;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+        int line = chunk->lines++;
+        if (line_end == p) {
+            p = next;
+            continue;
+        }
+
+        if (chunk->row_count == chunk->row_capacity) {
+            int capacity = chunk->row_capacity > 0 ? chunk->row_capacity * 2 : 1024;
+            ImportRow *temp = (ImportRow *)realloc(chunk->rows, capacity * sizeof(ImportRow));
+            if (temp == NULL) {
+                chunk->out_of_memory = 1;
+                return NULL;
+            }
+            chunk->rows = temp;
+            chunk->row_capacity = capacity;
+        }
+        ImportRow *row = &chunk->rows[chunk->row_count];
+        const char *reason = parse_csv_line(p, line_end, &row->record);
+        if (reason == NULL) {
+            row->line = line;
+            chunk->row_count++;
+        } else if (!(chunk->first && line == 0 && reason == IMPORT_BAD_ID)) {
+            // A first line without a numeric ID is a header
+            import_error(chunk, line, reason);
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+// Adds the parsed rows in file order, rejecting IDs already taken.
+// Returns the number added, or -1 if the columns could not be reserved.
+static int import_rows(ImportChunk *chunks, int count, const int *line_base, int *printed, int *rejected) {
+    long long total = 0;
+    for (int c = 0; c < count; c++) total += chunks[c].row_count;
+    long long fresh = total - free_count;
+    if (fresh > 0 && student_slots + fresh > student_capacity) {
+        if (student_slots + fresh > INT_MAX || !resize_columns((int)(student_slots + fresh))) return -1;
+    }
+    if (id_index_stale || id_index_used + total > id_index_capacity / 2) {
+        id_index_rebuild((int)(student_count + total));
+    }
+    // Rebuilt when next needed instead of once per row
+    name_index_invalidate();
+    range_index_invalidate();
+    report_totals_invalidate();
+
+    int added = 0;
+    for (int c = 0; c < count; c++) {
+        for (int r = 0; r < chunks[c].row_count; r++) {
+            const ImportRow *row = &chunks[c].rows[r];
+            const char *reason = NULL;
+            if (find_student(row->record.id) >= 0) {
+                reason = "ID already exists";
+            } else if (insert_student(&row->record) < 0) {
+                reason = "not enough memory";
+            }
+            if (reason != NULL) {
+                if ((*printed)++ < MAX_IMPORT_ERRORS) {
+                    printf("Line %d: %s.\n", line_base[c] + row->line, reason);
+                }
+                (*rejected)++;
+                continue;
+            }
+            added++;
+        }
+    }
+    return added;
+}
+
+// Adds every valid row of the CSV file at path. Returns 0 if the file
+// could not be read or the records stored.
+int import_csv(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror("Error opening file for import");
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        printf("File %s is empty. Nothing to import.\n", path);
+        return 1;
+    }
+    size_t length = (size_t)st.st_size;
+    void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Error mapping file for import");
+        return 0;
+    }
+    const char *data = (const char *)map;
+    madvise(map, length, MADV_SEQUENTIAL);
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cores < 1 ? 1 : (cores > MAX_IMPORT_THREADS ? MAX_IMPORT_THREADS : (int)cores);
+    if ((size_t)threads > length / IMPORT_CHUNK_MIN) threads = length / IMPORT_CHUNK_MIN > 0 ? (int)(length / IMPORT_CHUNK_MIN) : 1;
+
+    // Chunks start at the beginning of a line
+    ImportChunk chunks[MAX_IMPORT_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    for (int t = 0; t < threads; t++) {
+        size_t start = length * t / threads;
+        while (start > 0 && start < length && data[start - 1] != '\n') start++;
+        chunks[t].begin = data + start;
+        chunks[t].limit = data + length;
+        chunks[t].first = t == 0;
+    }
+    for (int t = 0; t < threads; t++) {
+        chunks[t].end = t + 1 < threads ? chunks[t + 1].begin : data + length;
+    }
+
+    // The calling thread takes the first chunk; a worker that fails to
+    // start has its chunk parsed here too
+    pthread_t workers[MAX_IMPORT_THREADS];
+    int started[MAX_IMPORT_THREADS] = { 0 };
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, import_scan, &chunks[t]) == 0;
+    }
+    import_scan(&chunks[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(workers[t], NULL);
+        else import_scan(&chunks[t]);
+    }
+
+    int ok = 1, printed = 0, rejected = 0, added = 0;
+    int line_base[MAX_IMPORT_THREADS];
+    for (int t = 0; t < threads; t++) {
+        line_base[t] = t > 0 ? line_base[t - 1] + chunks[t - 1].lines : 1;
+        if (chunks[t].out_of_memory) ok = 0;
+        for (int e = 0; e < chunks[t].error_count; e++) {
+            if (e < MAX_IMPORT_ERRORS && printed < MAX_IMPORT_ERRORS) {
+                printf("Line %d: %s.\n", line_base[t] + chunks[t].error_lines[e], chunks[t].error_reasons[e]);
+            }
+            printed++;
+            rejected++;
+        }
+    }
+    if (!ok) {
+        printf("Error: Not enough memory to parse %s.\n", path);
+    } else if ((added = import_rows(chunks, threads, line_base, &printed, &rejected)) < 0) {
+        printf("Error: Not enough memory to import the records.\n");
+        ok = 0;
+    } else {
+        if (printed > MAX_IMPORT_ERRORS) printf("... and %d more.\n", printed - MAX_IMPORT_ERRORS);
+        printf("Imported %d records from %s (%d line%s rejected).\n",
+               added, path, rejected, rejected == 1 ? "" : "s");
+    }
+
+    for (int t = 0; t < threads; t++) free(chunks[t].rows);
+    munmap(map, length);
+    return ok;
+}
+
+// Appends to the chunk's text; sets out_of_memory instead on failure
+static void export_append(ExportChunk *chunk, const char *text, size_t length) {
+    if (chunk->length + length > chunk->capacity) {
+        size_t capacity = chunk->capacity > 0 ? chunk->capacity * 2 : 1 << 16;
+        while (capacity < chunk->length + length) capacity *= 2;
+        char *temp = (char *)realloc(chunk->text, capacity);
+        if (temp == NULL) {
+            chunk->out_of_memory = 1;
+            return;
+        }
+        chunk->text = temp;
+        chunk->capacity = capacity;
+    }
+    memcpy(chunk->text + chunk->length, text, length);
+    chunk->length += length;
+}
+
+// Appends a field, quoted if it holds a comma or quote
+static void export_text(ExportChunk *chunk, const char *text) {
+    if (strpbrk(text, ",\"") == NULL) {
+        export_append(chunk, text, strlen(text));
+        return;
+    }
+    export_append(chunk, "\"", 1);
+    for (; *text != '\0'; text++) {
+        if (*text == '"') export_append(chunk, "\"", 1);
+        export_append(chunk, text, 1);
+    }
+    export_append(chunk, "\"", 1);
+}
+
+// Appends the shortest decimal that reads back as value
+static void export_float(ExportChunk *chunk, FloatCache *cache, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t hash = (bits ^ (bits >> 16)) * 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    int home = (int)((hash >> 16) % EXPORT_FLOAT_CACHE), entry = home;
+    for (int probe = 0; probe < EXPORT_FLOAT_PROBES; probe++) {
+        int e = (home + probe) % EXPORT_FLOAT_CACHE;
+        if (cache->text[e][0] != '\0' && cache->bits[e] == bits) {
+            export_append(chunk, cache->text[e], strlen(cache->text[e]));
+            return;
+        }
+        if (cache->text[e][0] == '\0') {
+            entry = e;
+            break;
+        }
+    }
+
+    char *text = cache->text[entry];
+    for (int digits = 1; digits <= 9; digits++) {
+        snprintf(text, sizeof(cache->text[entry]), "%.*g", digits, value);
+        if (strtof(text, NULL) == value) break;
+    }
+    cache->bits[entry] = bits;
+    export_append(chunk, text, strlen(text));
+}
+
+// Appends value in decimal; snprintf is several times slower
+static void export_int(ExportChunk *chunk, int value) {
+    char text[16];
+    int i = sizeof(text);
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        text[--i] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) text[--i] = '-';
+    export_append(chunk, text + i, sizeof(text) - i);
+}
+
+// Appends a GPA as %.2f would: gpa * 100 is exact in a double, and ties
+// round to even
+static void export_gpa(ExportChunk *chunk, float gpa) {
+    double hundredths = (double)gpa * 100;
+    long whole = (long)hundredths;
+    double fraction = hundredths - whole;
+    if (fraction > 0.5 || (fraction == 0.5 && (whole & 1))) whole++;
+    export_int(chunk, (int)(whole / 100));
+    char cents[3] = { '.', (char)('0' + whole % 100 / 10), (char)('0' + whole % 10) };
+    export_append(chunk, cents, sizeof(cents));
+}
+
+// Appends one record as a CSV line
+static void export_record(ExportChunk *chunk, FloatCache *cache, int id, const StudentDetails *details,
+                          int age, const char *course, float gpa) {
+    export_int(chunk, id);
+    export_append(chunk, ",", 1);
+    export_text(chunk, details->name);
+    export_append(chunk, ",", 1);
+    export_int(chunk, age);
+    export_append(chunk, ",", 1);
+    export_text(chunk, course);
+    for (int g = 0; g < MAX_GRADES; g++) {
+        export_append(chunk, ",", 1);
+        export_float(chunk, cache, details->grades[g]);
+    }
+    export_append(chunk, ",", 1);
+    export_gpa(chunk, gpa);
+    export_append(chunk, "\n", 1);
+}
+
+// Thread body: formats the rows of the chunk's slice of the order
+static void *export_format(void *arg) {
+    ExportChunk *chunk = (ExportChunk *)arg;
+    FloatCache cache;
+    memset(&cache, 0, sizeof(cache));
+    for (int k = chunk->from; k < chunk->to && !chunk->out_of_memory; k++) {
+        int slot = chunk->order[k];
+        export_record(chunk, &cache, student_ids[slot], &student_details[slot], student_ages[slot],
+                      student_course(slot), student_gpas[slot]);
+    }
+    return NULL;
+}
+
+// Writes every record to the CSV file at path, in display order. Slices
+// of the roster are formatted across threads and written in order.
+// Returns 0 on failure.
+int export_csv(const char *path) {
+    int *order = (int *)malloc((student_count + 1) * sizeof(int));
+    if (order == NULL) {
+        printf("Error: Not enough memory to export.\n");
+        return 0;
+    }
+    int n = 0;
+    int end = display_order_active ? display_order_count : student_slots;
+    for (int k = 0; k < end; k++) {
+        int slot = display_order_active ? display_order[k] : k;
+        if (slot >= 0 && student_live[slot]) order[n++] = slot;
+    }
+
+    int threads = 1;
+    if (n >= REPORT_PARALLEL_MIN) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores < 1 ? 1 : (cores > MAX_IMPORT_THREADS ? MAX_IMPORT_THREADS : (int)cores);
+    }
+    ExportChunk chunks[MAX_IMPORT_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    for (int t = 0; t < threads; t++) {
+        chunks[t].order = order;
+        chunks[t].from = (int)((long long)n * t / threads);
+        chunks[t].to = (int)((long long)n * (t + 1) / threads);
+    }
+    pthread_t workers[MAX_IMPORT_THREADS];
+    int started[MAX_IMPORT_THREADS] = { 0 };
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, export_format, &chunks[t]) == 0;
+    }
+    export_format(&chunks[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(workers[t], NULL);
+        else export_format(&chunks[t]);
+    }
+
+    int ok = 1;
+    for (int t = 0; t < threads; t++) {
+        if (chunks[t].out_of_memory) ok = 0;
+    }
+    FILE *fp = NULL;
+    if (!ok) {
+        printf("Error: Not enough memory to export.\n");
+    } else if ((fp = fopen(path, "w")) == NULL) {
+        perror("Error opening file for export");
+        ok = 0;
+    } else {
+        fprintf(fp, "id,name,age,course");
+        for (int g = 0; g < MAX_GRADES; g++) fprintf(fp, ",grade%d", g + 1);
+        fprintf(fp, ",gpa\n");
+        for (int t = 0; t < threads; t++) {
+            if (chunks[t].length > 0) fwrite(chunks[t].text, 1, chunks[t].length, fp);
+        }
+        ok = !ferror(fp);
+        if (fclose(fp) != 0) ok = 0;
+        if (!ok) perror("Error writing export file");
+    }
+
+    for (int t = 0; t < threads; t++) free(chunks[t].text);
+    free(order);
+    if (ok) printf("Exported %d records to %s.\n", n, path);
+    return ok;
+}
+
+// File Handling
+
+static const size_t store_element_size[STORE_REGIONS] = {
+    sizeof(int), sizeof(int), sizeof(float), sizeof(int), 1, sizeof(StudentDetails)
+};
+
+// Fletcher-64 over bytes / 4 native 32-bit words. The modulo is deferred
+// for 64K words at a time, which cannot overflow the accumulators.
+static uint64_t store_checksum(const void *data, size_t bytes) {
+    const uint32_t *words = (const uint32_t *)data;
+    size_t count = bytes / 4;
+    uint64_t sum1 = 0, sum2 = 0;
+    for (size_t i = 0; i < count; ) {
+        size_t block_end = count - i > 65536 ? i + 65536 : count;
+        for (; i < block_end; i++) {
+            sum1 += words[i];
+            sum2 += sum1;
+        }
+        sum1 %= 0xFFFFFFFFu;
+        sum2 %= 0xFFFFFFFFu;
+    }
+    return (sum2 << 32) | sum1;
+}
+
+// Fills in the byte offset of each column region of a store holding
+// capacity entries. Returns the number of data pages.
+static uint64_t store_layout(uint32_t capacity, size_t *offsets) {
+    size_t offset = STORE_PAGE_SIZE;
+    for (int r = 0; r < STORE_REGIONS; r++) {
+        offsets[r] = offset;
+        size_t bytes = (size_t)capacity * store_element_size[r];
+        offset += (bytes + STORE_PAGE_SIZE - 1) / STORE_PAGE_SIZE * STORE_PAGE_SIZE;
+    }
+    return offset / STORE_PAGE_SIZE - 1;
+}
+
+// Column of region r
+static void *store_column(int r) {
+    switch (r) {
+        case 0: return student_ids;
+        case 1: return student_ages;
+        case 2: return student_gpas;
+        case 3: return student_course_ids;
+        case 4: return student_live;
+        default: return student_details;
+    }
+}
+
+// Points each column at its region of a mapped store
+static void store_attach(unsigned char *base) {
+    student_ids = (int *)(base + store_region_offset[0]);
+    student_ages = (int *)(base + store_region_offset[1]);
+    student_gpas = (float *)(base + store_region_offset[2]);
+    student_course_ids = (int *)(base + store_region_offset[3]);
+    student_live = base + store_region_offset[4];
+    student_details = (StudentDetails *)(base + store_region_offset[5]);
+}
+
+// Flags the data pages holding positions [first, first + count) as changed
+void store_mark(int first, int count) {
+    if (count <= 0) return;
+    if (snapshot_dirty != NULL) snapshot_mark(first, count);
+    if (store_dirty == NULL) return;
+    for (int r = 0; r < STORE_REGIONS; r++) {
+        size_t start = store_region_offset[r] + (size_t)first * store_element_size[r];
+        size_t end = start + (size_t)count * store_element_size[r] - 1;
+        for (size_t page = start / STORE_PAGE_SIZE; page <= end / STORE_PAGE_SIZE; page++) {
+            store_dirty[page - 1] = 1;
+        }
+    }
+}
+
+// Verifier thread body: checks each data page of the file as saved
+// against its checksum, until done or told to stop
+static void *store_verify(void *arg) {
+    (void)arg;
+    uint32_t page[STORE_PAGE_SIZE / 4];
+    for (uint64_t p = 0; p < store_header.data_pages; p++) {
+        pthread_mutex_lock(&store_verify_lock);
+        int stop = store_verify_stop;
+        pthread_mutex_unlock(&store_verify_lock);
+        if (stop) break;
+
+        int ok = pread(store_verify_fd, page, STORE_PAGE_SIZE, (off_t)(p + 1) * STORE_PAGE_SIZE) == STORE_PAGE_SIZE &&
+                 store_checksum(page, STORE_PAGE_SIZE) == store_checksums[p];
+        pthread_mutex_lock(&store_verify_lock);
+        store_verify_checked++;
+        if (!ok && store_verify_bad++ == 0) store_verify_first_bad = p + 1;
+        pthread_mutex_unlock(&store_verify_lock);
+    }
+    return NULL;
+}
+
+// Prints a warning for the damaged pages the verifier has found since the
+// last call
+void store_report_damage() {
+    pthread_mutex_lock(&store_verify_lock);
+    uint64_t bad = store_verify_bad, first = store_verify_first_bad;
+    store_verify_bad = 0;
+    pthread_mutex_unlock(&store_verify_lock);
+    if (bad > 0) {
+        printf("Warning: %llu page(s) of %s failed their checksum (first: page %llu).\n"
+               "Records stored there may be damaged.\n",
+               (unsigned long long)bad, STORE_FILENAME, (unsigned long long)first);
+    }
+}
+
+// Stops the verifier and reports what it found
+static void store_verify_finish(void) {
+    if (!store_verifier_running) return;
+    pthread_mutex_lock(&store_verify_lock);
+    store_verify_stop = 1;
+    pthread_mutex_unlock(&store_verify_lock);
+    pthread_join(store_verifier, NULL);
+    store_verifier_running = 0;
+    close(store_verify_fd);
+    store_verify_fd = -1;
+    store_report_damage();
+}
+
+// Starts verifying the store open on fd, which the verifier then owns
+static void store_verify_start(int fd) {
+    store_verify_fd = fd;
+    store_verify_stop = 0;
+    store_verify_checked = 0;
+    store_verify_bad = 0;
+    store_verifier_running = pthread_create(&store_verifier, NULL, store_verify, NULL) == 0;
+    if (!store_verifier_running) {
+        close(fd);
+        store_verify_fd = -1;
+    }
+}
+
+// Unmaps the store, dropping changes made since the last save. The column
+// pointers are left for the caller to replace.
+void store_close() {
+    store_verify_finish();
+    if (store_map != NULL) munmap(store_map, store_map_length);
+    store_map = NULL;
+    store_map_length = 0;
+    free(store_checksums);
+    store_checksums = NULL;
+    free(store_dirty);
+    store_dirty = NULL;
+}
+
+// Frees the columns, or unmaps the store they point into
+static void release_columns(void) {
+    if (store_map != NULL) {
+        store_close();
+    } else {
+        free(student_ids);
+        free(student_ages);
+        free(student_gpas);
+        free(student_course_ids);
+        free(student_live);
+        free(student_details);
+    }
+    student_ids = NULL;
+    student_ages = NULL;
+    student_gpas = NULL;
+    student_course_ids = NULL;
+    student_live = NULL;
+    student_details = NULL;
+}
+
+// Copies the columns out of the store onto the heap; the next save then
+// writes a new file. Returns 0, changing nothing, if out of memory.
+int store_detach() {
+    void *copies[STORE_REGIONS];
+    int ok = 1;
+    for (int r = 0; r < STORE_REGIONS; r++) {
+        copies[r] = malloc((size_t)student_capacity * store_element_size[r]);
+        if (copies[r] == NULL) ok = 0;
+    }
+    if (!ok) {
+        for (int r = 0; r < STORE_REGIONS; r++) free(copies[r]);
+        return 0;
+    }
+    for (int r = 0; r < STORE_REGIONS; r++) {
+        memcpy(copies[r], store_column(r), (size_t)student_slots * store_element_size[r]);
+    }
+    release_columns();
+    student_ids = copies[0];
+    student_ages = copies[1];
+    student_gpas = copies[2];
+    student_course_ids = copies[3];
+    student_live = copies[4];
+    student_details = copies[5];
+    return 1;
+}
+
+// Maps the header and data pages of the store h open on fd and points the
+// columns into them, replacing the current ones. Takes ownership of
+// checksums. Returns 0, changing nothing, if the mapping fails.
+static int store_adopt(int fd, const StoreHeader *h, const size_t *offsets, uint64_t *checksums) {
+    size_t length = (h->data_pages + 1) * STORE_PAGE_SIZE;
+    unsigned char *dirty = (unsigned char *)calloc(h->data_pages + 1, 1);
+    void *map = dirty != NULL ? mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        free(dirty);
+        free(checksums);
+        return 0;
+    }
+
+    release_columns();
+    store_map = (unsigned char *)map;
+    store_map_length = length;
+    store_header = *h;
+    memcpy(store_region_offset, offsets, sizeof(store_region_offset));
+    store_checksums = checksums;
+    store_dirty = dirty;
+    store_attach(store_map);
+    student_capacity = (int)h->capacity;
+    return 1;
+}
+
+static int write_at(int fd, const void *data, size_t bytes, off_t offset) {
+    const char *p = (const char *)data;
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, p, bytes, offset);
+        if (n <= 0) return 0;
+        p += n;
+        bytes -= n;
+        offset += n;
+    }
+    return 1;
+}
+
+static int read_at(int fd, void *data, size_t bytes, off_t offset) {
+    char *p = (char *)data;
+    while (bytes > 0) {
+        ssize_t n = pread(fd, p, bytes, offset);
+        if (n <= 0) return 0;
+        p += n;
+        bytes -= n;
+        offset += n;
+    }
+    return 1;
+}
+
+static off_t page_round(off_t bytes) {
+    return (bytes + STORE_PAGE_SIZE - 1) / STORE_PAGE_SIZE * STORE_PAGE_SIZE;
+}
+
+// First offset after the data pages of h, where a tail may start
+static off_t store_tail_base(const StoreHeader *h) {
+    return (off_t)(h->data_pages + 1) * STORE_PAGE_SIZE;
+}
+
+// Offset of the course dictionary of h, after its checksum table
+static off_t store_courses_offset(const StoreHeader *h) {
+    return (off_t)h->tail_offset + page_round(h->data_pages * sizeof(uint64_t));
+}
+
+static off_t store_tail_end(const StoreHeader *h) {
+    return store_courses_offset(h) + (off_t)h->course_count * sizeof(StoreCourse);
+}
+
+// Writes the page checksums and the course dictionary at the tail offset
+// of h and records their checksums in h. The file then ends after the
+// tail, or at keep if that is further.
+static int store_write_tail(int fd, StoreHeader *h, const uint64_t *checksums, off_t keep) {
+    StoreCourse *entries = (StoreCourse *)calloc(course_count + 1, sizeof(StoreCourse));
+    if (entries == NULL) return 0;
+    for (int c = 0; c < course_count; c++) {
+        strncpy(entries[c].name, courses[c].name, COURSE_NAME_SIZE - 1);
+        entries[c].enrolled = courses[c].enrolled;
+    }
+
+    size_t table_bytes = h->data_pages * sizeof(uint64_t);
+    size_t courses_bytes = course_count * sizeof(StoreCourse);
+    h->course_count = course_count;
+    h->table_checksum = store_checksum(checksums, table_bytes);
+    h->courses_checksum = store_checksum(entries, courses_bytes);
+    off_t end = store_tail_end(h);
+    int ok = write_at(fd, checksums, table_bytes, (off_t)h->tail_offset) &&
+             write_at(fd, entries, courses_bytes, store_courses_offset(h)) &&
+             ftruncate(fd, end > keep ? end : keep) == 0;
+    free(entries);
+    return ok;
+}
+
+// Syncs everything written so far, then writes h, so a header never
+// describes pages that are not on disk yet
+static int store_write_header(int fd, StoreHeader *h) {
+    h->header_checksum = store_checksum(h, offsetof(StoreHeader, header_checksum));
+    return fsync(fd) == 0 && write_at(fd, h, sizeof(*h), 0) && fsync(fd) == 0;
+}
+
+// Writes the data pages changed since the last save back into the store,
+// then the tail and header. Returns 0 on failure.
+static int store_write_back(int *pages_written) {
+    int fd = open(STORE_FILENAME, O_RDWR);
+    if (fd < 0) return 0;
+
+    StoreHeader h = store_header;
+    int ok = wal_save_pages(fd);
+    *pages_written = 0;
+    for (uint64_t p = 0; ok && p < h.data_pages; p++) {
+        if (!store_dirty[p]) continue;
+        const unsigned char *page = store_map + (p + 1) * STORE_PAGE_SIZE;
+        store_checksums[p] = store_checksum(page, STORE_PAGE_SIZE);
+        ok = write_at(fd, page, STORE_PAGE_SIZE, (off_t)(p + 1) * STORE_PAGE_SIZE);
+        (*pages_written)++;
+    }
+    h.slots = student_slots;
+    h.count = student_count;
+    h.generation++;
+
+    // The new tail goes at the start of the tail area if it fits before
+    // the current one, else after it
+    off_t base = store_tail_base(&h);
+    off_t tail_bytes = page_round(h.data_pages * sizeof(uint64_t)) + (off_t)course_count * sizeof(StoreCourse);
+    h.tail_offset = (off_t)store_header.tail_offset >= base + tail_bytes ? base : page_round(store_tail_end(&store_header));
+    ok = ok && store_write_tail(fd, &h, store_checksums, store_tail_end(&store_header)) &&
+         store_write_header(fd, &h);
+    if (close(fd) != 0) ok = 0;
+    if (!ok) return 0;
+
+    store_header = h;
+    memset(store_dirty, 0, h.data_pages);
+    return 1;
+}
+
+// Writes the whole roster to a new store file, renames it over the old one
+// and maps it in place of the columns. Returns 0 on failure.
+static int store_write_full(void) {
+    StoreHeader h;
+    size_t offsets[STORE_REGIONS];
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, STORE_MAGIC, 4);
+    h.version = STORE_VERSION;
+    h.page_size = STORE_PAGE_SIZE;
+    h.details_size = sizeof(StudentDetails);
+    h.capacity = student_capacity;
+    h.slots = student_slots;
+    h.count = student_count;
+    h.generation = store_header.generation + 1;
+    h.data_pages = store_layout(h.capacity, offsets);
+    h.tail_offset = store_tail_base(&h);
+
+    uint64_t *checksums = (uint64_t *)malloc((h.data_pages + 1) * sizeof(uint64_t));
+    unsigned char *page = (unsigned char *)malloc(STORE_PAGE_SIZE);
+    int fd = open(STORE_TEMP_FILENAME, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int ok = checksums != NULL && page != NULL && fd >= 0;
+
+    // Each region a page at a time; unused positions are written as zeros
+    uint64_t p = 0;
+    for (int r = 0; ok && r < STORE_REGIONS; r++) {
+        const unsigned char *column = (const unsigned char *)store_column(r);
+        size_t used = (size_t)student_slots * store_element_size[r];
+        size_t end = (r + 1 < STORE_REGIONS ? offsets[r + 1] : (h.data_pages + 1) * STORE_PAGE_SIZE) - offsets[r];
+        for (size_t offset = 0; ok && offset < end; offset += STORE_PAGE_SIZE) {
+            memset(page, 0, STORE_PAGE_SIZE);
+            if (offset < used) {
+                memcpy(page, column + offset, used - offset < STORE_PAGE_SIZE ? used - offset : STORE_PAGE_SIZE);
+            }
+            checksums[p] = store_checksum(page, STORE_PAGE_SIZE);
+            ok = write_at(fd, page, STORE_PAGE_SIZE, (off_t)(p + 1) * STORE_PAGE_SIZE);
+            p++;
+        }
+    }
+    free(page);
+    ok = ok && store_write_tail(fd, &h, checksums, 0) && store_write_header(fd, &h);
+
+    if (!ok || rename(STORE_TEMP_FILENAME, STORE_FILENAME) != 0) {
+        perror("Error writing record store");
+        if (fd >= 0) close(fd);
+        remove(STORE_TEMP_FILENAME);
+        free(checksums);
+        return 0;
+    }
+    store_header.generation = h.generation;
+    store_adopt(fd, &h, offsets, checksums);
+    close(fd);
+    return 1;
+}
+
+// Write-Ahead Log
+// Every change made through the menu is logged by id, not position, so
+// replaying it does not depend on where records were stored. The flusher
+// thread waits up to WAL_COMMIT_MS for more records before writing a
+// group with one fdatasync: a crash loses at most that window, and a run
+// of edits shares its syncs. A save is the checkpoint: it syncs the log,
+// writes the store under a new generation, then empties the log and binds
+// it to that generation. A log bound to the loaded generation is replayed.
+//
+// Saves overwrite changed store pages in place, so a crash mid-save can
+// leave a mix of old and new pages. Before overwriting, the save logs each
+// page as it is on disk; recovery puts those back first, returning the
+// store to the generation the log's records apply to.
+
+// Writes a group of records at the end of the log and syncs it
+static int wal_write_group(const unsigned char *group, size_t length, off_t offset) {
+    return write_at(wal_fd, group, length, offset) && fdatasync(wal_fd) == 0;
+}
+
+// Flusher thread body
+static void *wal_flush_loop(void *arg) {
+    (void)arg;
+    unsigned char *group = NULL;
+    size_t group_capacity = 0;
+    pthread_mutex_lock(&wal_lock);
+    for (;;) {
+        while (wal_queue_length == 0 && !wal_stop) pthread_cond_wait(&wal_wake, &wal_lock);
+        if (wal_queue_length == 0) break;
+
+        // Let more records join the group
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += WAL_COMMIT_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!wal_flush_now && !wal_stop &&
+               pthread_cond_timedwait(&wal_wake, &wal_lock, &deadline) == 0) {
+        }
+        wal_flush_now = 0;
+
+        // Swap queues, so records logged during the write start a new group
+        unsigned char *queued = wal_queue;
+        size_t length = wal_queue_length, queued_capacity = wal_queue_capacity;
+        uint64_t target = wal_logged;
+        off_t offset = wal_end;
+        wal_queue = group;
+        wal_queue_capacity = group_capacity;
+        wal_queue_length = 0;
+        group = queued;
+        group_capacity = queued_capacity;
+
+        pthread_mutex_unlock(&wal_lock);
+        int ok = wal_write_group(group, length, offset);
+        pthread_mutex_lock(&wal_lock);
+        if (ok) {
+            wal_end += length;
+            wal_durable = target;
+        } else {
+            wal_failed = 1;
+        }
+        pthread_cond_broadcast(&wal_flushed);
+    }
+    pthread_mutex_unlock(&wal_lock);
+    free(group);
+    return NULL;
+}
+
+static void wal_report_failure(void) {
+    printf("Error: Could not write %s. Changes are kept only until the next save.\n", WAL_FILENAME);
+}
+
+// Queues a record; it reaches the disk with the flusher's next group
+void wal_log(uint32_t op, const void *payload, uint32_t length) {
+    if (wal_fd < 0) return;
+    pthread_mutex_lock(&wal_lock);
+    int failed = wal_failed;
+    size_t bytes = 2 * sizeof(uint32_t) + length + sizeof(uint64_t);
+    if (!failed && wal_queue_length + bytes > wal_queue_capacity) {
+        size_t capacity = wal_queue_capacity > 0 ? wal_queue_capacity * 2 : 4096;
+        while (capacity < wal_queue_length + bytes) capacity *= 2;
+        unsigned char *temp = (unsigned char *)realloc(wal_queue, capacity);
+        if (temp == NULL) {
+            wal_failed = failed = 1;
+        } else {
+            wal_queue = temp;
+            wal_queue_capacity = capacity;
+        }
+    }
+    if (!failed) {
+        unsigned char *record = wal_queue + wal_queue_length;
+        memcpy(record, &op, sizeof(uint32_t));
+        memcpy(record + 4, &length, sizeof(uint32_t));
+        memcpy(record + 8, payload, length);
+        uint64_t checksum = store_checksum(record, 8 + length);
+        memcpy(record + 8 + length, &checksum, sizeof(checksum));
+        wal_queue_length += bytes;
+        wal_logged += bytes;
+
+        if (wal_flusher_running) {
+            pthread_cond_signal(&wal_wake);
+        } else if (wal_write_group(wal_queue, wal_queue_length, wal_end)) {
+            // Without a flusher every record is synced on its own
+            wal_end += wal_queue_length;
+            wal_durable = wal_logged;
+            wal_queue_length = 0;
+        } else {
+            wal_failed = failed = 1;
+        }
+    }
+    pthread_mutex_unlock(&wal_lock);
+    if (failed) wal_report_failure();
+}
+
+// Logs the record at slot as stored, padding included
+void wal_log_student(int slot) {
+    Student record;
+    memset(&record, 0, sizeof(record));
+    get_student(slot, &record);
+    wal_log(WAL_PUT, &record, sizeof(record));
+}
+
+void wal_log_rename(const char *old_name, const char *new_name) {
+    char names[2 * COURSE_NAME_SIZE] = { 0 };
+    memcpy(names, old_name, strnlen(old_name, COURSE_NAME_SIZE - 1));
+    memcpy(names + COURSE_NAME_SIZE, new_name, strnlen(new_name, COURSE_NAME_SIZE - 1));
+    wal_log(WAL_RENAME, names, sizeof(names));
+}
+
+// Waits until every queued record is on disk. Returns 0 if the log failed.
+static int wal_sync(void) {
+    if (wal_fd < 0) return 1;
+    pthread_mutex_lock(&wal_lock);
+    uint64_t target = wal_logged;
+    wal_flush_now = 1;
+    pthread_cond_signal(&wal_wake);
+    while (wal_flusher_running && wal_durable < target && !wal_failed) {
+        pthread_cond_wait(&wal_flushed, &wal_lock);
+    }
+    int ok = !wal_failed;
+    pthread_mutex_unlock(&wal_lock);
+    return ok;
+}
+
+// Logs the saved contents of the dirty pages of the store open on
+// store_fd, ahead of their overwrite by a save. Returns 0 if they could not
+// be logged. Called with the queue empty, after wal_sync.
+int wal_save_pages(int store_fd) {
+    if (wal_fd < 0) return 1;
+    size_t record_bytes = 16 + sizeof(uint64_t) + STORE_PAGE_SIZE;
+    unsigned char *block = (unsigned char *)malloc(IO_BLOCK_RECORDS * record_bytes);
+    if (block == NULL) return 0;
+
+    uint32_t op = WAL_PAGE, length = sizeof(uint64_t) + STORE_PAGE_SIZE;
+    off_t end = wal_end;
+    int ok = 1, queued = 0;
+    for (uint64_t p = 0; ok && p <= store_header.data_pages; p++) {
+        if (p < store_header.data_pages && !store_dirty[p]) continue;
+        if (p == store_header.data_pages || queued == IO_BLOCK_RECORDS) {
+            ok = write_at(wal_fd, block, queued * record_bytes, end);
+            end += queued * record_bytes;
+            queued = 0;
+            if (p == store_header.data_pages) break;
+        }
+        unsigned char *record = block + queued * record_bytes;
+        uint64_t page = p + 1;
+        memcpy(record, &op, sizeof(op));
+        memcpy(record + 4, &length, sizeof(length));
+        memcpy(record + 8, &page, sizeof(page));
+        ok = ok && read_at(store_fd, record + 16, STORE_PAGE_SIZE, (off_t)page * STORE_PAGE_SIZE);
+        uint64_t checksum = store_checksum(record, 8 + length);
+        memcpy(record + 8 + length, &checksum, sizeof(checksum));
+        queued++;
+    }
+    free(block);
+    ok = ok && fdatasync(wal_fd) == 0;
+
+    pthread_mutex_lock(&wal_lock);
+    if (ok) {
+        wal_end = end;
+    } else {
+        wal_failed = 1;
+    }
+    pthread_mutex_unlock(&wal_lock);
+    return ok;
+}
+
+// Puts back the store pages logged by a save that did not finish, before
+// the store is loaded
+static void wal_restore_pages(void) {
+    int fd = open(WAL_FILENAME, O_RDONLY);
+    if (fd < 0) return;
+    int store_fd = open(STORE_FILENAME, O_RDWR);
+    WalHeader h;
+    StoreHeader sh;
+    struct stat st;
+    if (store_fd < 0 || fstat(fd, &st) != 0 || !read_at(fd, &h, sizeof(h), 0) ||
+        !read_at(store_fd, &sh, sizeof(sh), 0) || memcmp(h.magic, WAL_MAGIC, 4) != 0 ||
+        h.version != WAL_VERSION || h.generation != sh.generation) {
+        if (store_fd >= 0) close(store_fd);
+        close(fd);
+        return;
+    }
+
+    unsigned char record[16 + sizeof(uint64_t) + STORE_PAGE_SIZE];
+    off_t end = sizeof(h);
+    int restored = 0;
+    while (end + 16 <= st.st_size) {
+        uint32_t op, size;
+        uint64_t checksum, page;
+        if (!read_at(fd, record, 8, end)) break;
+        memcpy(&op, record, sizeof(op));
+        memcpy(&size, record + 4, sizeof(size));
+        if (size % 4 != 0 || size > (uint64_t)(st.st_size - end - 16)) break;
+        if (op == WAL_PAGE && size == sizeof(record) - 16) {
+            if (!read_at(fd, record + 8, size + 8, end + 8)) break;
+            memcpy(&checksum, record + 8 + size, sizeof(checksum));
+            if (checksum != store_checksum(record, 8 + size)) break;
+            memcpy(&page, record + 8, sizeof(page));
+            if (page == 0 || page > sh.data_pages ||
+                !write_at(store_fd, record + 16, STORE_PAGE_SIZE, (off_t)page * STORE_PAGE_SIZE)) {
+                break;
+            }
+            restored++;
+        }
+        end += 16 + size;
+    }
+    if (restored > 0 && fsync(store_fd) != 0) perror("Error restoring record store");
+    close(store_fd);
+    close(fd);
+}
+
+// Writes a header binding the log to generation, dropping every record.
+// Nothing may be queued.
+static int wal_reset(uint64_t generation) {
+    WalHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, WAL_MAGIC, 4);
+    h.version = WAL_VERSION;
+    h.generation = generation;
+    int ok = write_at(wal_fd, &h, sizeof(h), 0) && ftruncate(wal_fd, sizeof(h)) == 0 &&
+             fdatasync(wal_fd) == 0;
+    pthread_mutex_lock(&wal_lock);
+    wal_end = sizeof(h);
+    if (!ok) wal_failed = 1;
+    pthread_mutex_unlock(&wal_lock);
+    return ok;
+}
+
+// Applies one logged change. Returns 0 if it is malformed or could not be
+// applied.
+static int wal_apply(uint32_t op, const unsigned char *payload, uint32_t length) {
+    if (op == WAL_PUT && length == sizeof(Student)) {
+        Student s;
+        memcpy(&s, payload, sizeof(s));
+        s.name[sizeof(s.name) - 1] = '\0';
+        s.course[sizeof(s.course) - 1] = '\0';
+        return upsert_student(&s) >= 0;
+    }
+    if (op == WAL_DELETE && length == sizeof(int)) {
+        int id;
+        memcpy(&id, payload, sizeof(id));
+        int slot = find_student(id);
+        if (slot >= 0) remove_student(slot);
+        return 1;
+    }
+    if (op == WAL_RENAME && length == 2 * COURSE_NAME_SIZE) {
+        char names[2 * COURSE_NAME_SIZE];
+        memcpy(names, payload, sizeof(names));
+        names[COURSE_NAME_SIZE - 1] = '\0';
+        names[2 * COURSE_NAME_SIZE - 1] = '\0';
+        int id = course_lookup(names);
+        if (id >= 0) course_rename(id, names + COURSE_NAME_SIZE);
+        return 1;
+    }
+    // Page images were restored before the store was loaded
+    return op == WAL_PAGE && length == sizeof(uint64_t) + STORE_PAGE_SIZE;
+}
+
+// Applies the records of the log open on fd, of length bytes, up to the
+// first torn or corrupted one. Returns the offset after the last intact
+// record and sets *applied. If a record cannot be applied (or the log
+// cannot be read) *failed is set; the records after it are then only
+// checked, so that just a torn tail is ever cut off.
+static off_t wal_replay(int fd, off_t length, int *applied, int *failed) {
+    off_t end = sizeof(WalHeader);
+    *applied = 0;
+    *failed = 0;
+    if (length <= end) return end;
+    unsigned char *log = (unsigned char *)malloc(length);
+    if (log == NULL || !read_at(fd, log, length, 0)) {
+        free(log);
+        *failed = 1;
+        return length;
+    }
+
+    while (end + 16 <= length) {
+        uint32_t op, size;
+        uint64_t checksum;
+        memcpy(&op, log + end, sizeof(op));
+        memcpy(&size, log + end + 4, sizeof(size));
+        if (size % 4 != 0 || size > (uint64_t)(length - end - 16)) break;
+        memcpy(&checksum, log + end + 8 + size, sizeof(checksum));
+        if (checksum != store_checksum(log + end, 8 + size)) break;
+        if (!*failed && !wal_apply(op, log + end + 8, size)) *failed = 1;
+        else if (!*failed && op != WAL_PAGE) (*applied)++;
+        end += 16 + size;
+    }
+    free(log);
+    return end;
+}
+
+// Opens the log for the store generation just loaded: replays it if it is
+// bound to that generation, else starts it afresh, and starts the flusher
+static void wal_open(uint64_t generation) {
+    int fd = open(WAL_FILENAME, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("Error opening write-ahead log");
+        return;
+    }
+
+    WalHeader h;
+    struct stat st;
+    int applied = 0;
+    off_t end = 0;
+    wal_unapplied = 0;
+    if (fstat(fd, &st) == 0 && read_at(fd, &h, sizeof(h), 0) &&
+        memcmp(h.magic, WAL_MAGIC, 4) == 0 && h.version == WAL_VERSION && h.generation == generation) {
+        end = wal_replay(fd, st.st_size, &applied, &wal_unapplied);
+    }
+
+    wal_fd = fd;
+    wal_failed = 0;
+    wal_stop = 0;
+    wal_flush_now = 0;
+    wal_queue_length = 0;
+    if (end == 0) {
+        if (!wal_reset(generation)) {
+            wal_report_failure();
+            return;
+        }
+    } else {
+        // Drop a torn tail, so new records follow the last good one
+        wal_end = end;
+        if (ftruncate(fd, end) != 0) wal_failed = 1;
+    }
+    wal_flusher_running = pthread_create(&wal_flusher, NULL, wal_flush_loop, NULL) == 0;
+    if (wal_unapplied) {
+        // New changes are logged after the records not applied; the next
+        // load replays them all in order
+        printf("Error: Could not apply every change in %s (out of memory?).\n", WAL_FILENAME);
+        printf("The log is kept and saving is disabled; reload once memory is available.\n");
+    } else if (applied > 0) {
+        printf("Recovered %d change%s from %s.\n", applied, applied == 1 ? "" : "s", WAL_FILENAME);
+        save_records();
+    }
+}
+
+// Syncs the log and stops the flusher. The file stays for the next load.
+void wal_close() {
+    if (wal_fd < 0) return;
+    wal_sync();
+    if (wal_flusher_running) {
+        pthread_mutex_lock(&wal_lock);
+        wal_stop = 1;
+        pthread_cond_signal(&wal_wake);
+        pthread_mutex_unlock(&wal_lock);
+        pthread_join(wal_flusher, NULL);
+        wal_flusher_running = 0;
+    }
+    close(wal_fd);
+    wal_fd = -1;
+    free(wal_queue);
+    wal_queue = NULL;
+    wal_queue_capacity = 0;
+    wal_queue_length = 0;
+}
+
+// Checkpoints once the log has grown past WAL_CHECKPOINT_BYTES
+void wal_checkpoint_if_due() {
+    if (wal_fd < 0 || wal_unapplied) return;
+    pthread_mutex_lock(&wal_lock);
+    uint64_t size = (uint64_t)wal_end + wal_queue_length;
+    pthread_mutex_unlock(&wal_lock);
+    if (size > WAL_CHECKPOINT_BYTES) save_records();
+}
+
+void save_records() {
+    // A save starts a new generation, orphaning records not yet applied
+    if (wal_unapplied) {
+        printf("Error: Not saving; %s holds changes that could not be applied.\n", WAL_FILENAME);
+        return;
+    }
+    // The log must hold every change before store pages are overwritten
+    if (!wal_sync()) wal_report_failure();
+    store_verify_finish();
+    int pages = 0;
+    if (store_map != NULL && store_write_back(&pages)) {
+        printf("\nSuccessfully saved %d records to %s (%d page%s written).\n",
+               student_count, STORE_FILENAME, pages, pages == 1 ? "" : "s");
+    } else if (store_write_full()) {
+        printf("\nSuccessfully saved %d records to %s.\n", student_count, STORE_FILENAME);
+    } else {
+        return;
+    }
+    if (wal_fd >= 0 && !wal_reset(store_header.generation)) wal_report_failure();
+}
+
+// Maps STORE_FILENAME in place of the current roster. Deleted positions
+// in it are reclaimed by the next compaction rather than the free list.
+// Returns 1 if it loaded, 0 if it does not exist and -1 if it could not
+// be loaded.
+static int load_store(void) {
+    int fd = open(STORE_FILENAME, O_RDONLY);
+    if (fd < 0) return 0;
+
+    StoreHeader h;
+    size_t offsets[STORE_REGIONS];
+    struct stat st;
+    int ok = fstat(fd, &st) == 0 && read_at(fd, &h, sizeof(h), 0) &&
+             memcmp(h.magic, STORE_MAGIC, 4) == 0 && h.version == STORE_VERSION &&
+             h.page_size == STORE_PAGE_SIZE && h.details_size == sizeof(StudentDetails) &&
+             h.header_checksum == store_checksum(&h, offsetof(StoreHeader, header_checksum)) &&
+             h.capacity > 0 && h.capacity <= 0x7FFFFFFF && h.slots <= h.capacity && h.count <= h.slots &&
+             store_layout(h.capacity, offsets) == h.data_pages &&
+             (off_t)h.tail_offset >= store_tail_base(&h) && h.tail_offset % STORE_PAGE_SIZE == 0 &&
+             st.st_size >= store_tail_end(&h);
+    if (!ok) {
+        printf("File %s has an unsupported or corrupted header.\n", STORE_FILENAME);
+        close(fd);
+        return -1;
     }
 
-    for (int i = 0; i < student_count; i++) {
-        if (student_list[i].id == id_to_delete) {
-            if (i < student_count - 1) {
-                memmove(&student_list[i], &student_list[i + 1], 
-                        (student_count - 1 - i) * sizeof(Student));
-            }
-            student_count--;
-            printf("Student with ID %d deleted.\n", id_to_delete);
-            return;
+    size_t table_bytes = h.data_pages * sizeof(uint64_t);
+    size_t courses_bytes = h.course_count * sizeof(StoreCourse);
+    uint64_t *checksums = (uint64_t *)malloc(table_bytes + sizeof(uint64_t));
+    StoreCourse *entries = (StoreCourse *)malloc(courses_bytes + sizeof(StoreCourse));
+    ok = checksums != NULL && entries != NULL &&
+         read_at(fd, checksums, table_bytes, (off_t)h.tail_offset) &&
+         read_at(fd, entries, courses_bytes, store_courses_offset(&h)) &&
+         store_checksum(checksums, table_bytes) == h.table_checksum &&
+         store_checksum(entries, courses_bytes) == h.courses_checksum;
+    if (!ok) {
+        printf("File %s is corrupted.\n", STORE_FILENAME);
+        free(checksums);
+        free(entries);
+        close(fd);
+        return -1;
+    }
+    if (!store_adopt(fd, &h, offsets, checksums)) {
+        perror("Error mapping record store");
+        free(entries);
+        close(fd);
+        return -1;
+    }
+
+    // Courses keep their saved numbers
+    course_clear();
+    for (uint32_t c = 0; c < h.course_count; c++) {
+        entries[c].name[COURSE_NAME_SIZE - 1] = '\0';
+        if (course_intern(entries[c].name) != (int)c) break;
+        courses[c].enrolled = entries[c].enrolled;
+    }
+    free(entries);
+    student_slots = (int)h.slots;
+    student_count = (int)h.count;
+    if (course_count != (int)h.course_count) {
+        printf("Error: Not enough memory for the course dictionary.\n");
+        student_slots = 0;
+        student_count = 0;
+    }
+    free_count = 0;
+    id_index_invalidate();
+    name_index_invalidate();
+    range_index_invalidate();
+    report_totals_invalidate();
+    display_order_active = 0;
+    store_verify_start(fd);
+    printf("\nSuccessfully loaded %d records from %s.\n", student_count, STORE_FILENAME);
+    return 1;
+}
+
+// Interns the dictionary stored after saved_count records, in its saved
+// order, so courses keep their numbers. Leaves fp at the first record.
+static void load_course_dictionary(FILE *fp, int saved_count) {
+    char magic[4];
+    int count = 0;
+    char name[COURSE_NAME_SIZE];
+    if (fseek(fp, sizeof(int) + (long)saved_count * sizeof(Student), SEEK_SET) == 0 &&
+        fread(magic, 1, 4, fp) == 4 && memcmp(magic, COURSE_DICT_MAGIC, 4) == 0 &&
+        fread(&count, sizeof(int), 1, fp) == 1) {
+        for (int c = 0; c < count && fread(name, 1, COURSE_NAME_SIZE, fp) == COURSE_NAME_SIZE; c++) {
+            name[COURSE_NAME_SIZE - 1] = '\0';
+            if (course_intern(name) < 0) break;
         }
     }
-    printf("Error: Student with ID %d not found.\n", id_to_delete);
+    fseek(fp, sizeof(int), SEEK_SET);
 }
 
+// Reads a roster saved by an older version as Student records; the next
+// save writes it to the record store
+static void load_legacy_records(void) {
+    FILE *fp = fopen(FILENAME, "r");
+    if (fp == NULL) {
+        perror("Error opening file for loading. Starting with empty list.");
+        return;
+    }
 
-void update_student() {
-    if (student_count == 0) {
-        printf("No student records available to update.\n");
+    // Read the total number of records
+    int saved_count = 0;
+    if (fread(&saved_count, sizeof(int), 1, fp) != 1 || saved_count < 0) {
+        printf("File is empty or corrupted.\n");
+        fclose(fp);
         return;
     }
 
-    int id_to_update;
-    printf("\n--- Update Student Record ---\n");
-    printf("Enter ID of student to update: ");
-    if (scanf("%d", &id_to_update) != 1) {
-        printf("Invalid input.\n");
-        while (getchar() != '\n'); // Clear buffer
+    Student *block = (Student *)malloc(IO_BLOCK_RECORDS * sizeof(Student));
+    if (block == NULL || (store_map != NULL && !store_detach()) ||
+        (saved_count > student_capacity && !resize_columns(saved_count))) {
+        perror("Error reallocating memory for loaded data");
+        free(block);
+        fclose(fp);
         return;
     }
 
-    int index = -1;
-    // Search for the student
-    for (int i = 0; i < student_count; i++) {
-        if (student_list[i].id == id_to_update) {
-            index = i;
-            break;
+    student_count = 0;
+    student_slots = 0;
+    free_count = 0;
+    if (saved_count > 0) memset(student_live, 0, saved_count);
+    range_index_invalidate();
+    report_totals_invalidate();
+    course_clear();
+    load_course_dictionary(fp, saved_count);
+
+    // Read the records a block at a time and spread them over the columns
+    int loaded = 0;
+    while (loaded < saved_count) {
+        int n = saved_count - loaded < IO_BLOCK_RECORDS ? saved_count - loaded : IO_BLOCK_RECORDS;
+        int got = (int)fread(block, sizeof(Student), n, fp);
+        int stored = 0;
+        for (; stored < got; stored++) {
+            block[stored].name[sizeof(block[stored].name) - 1] = '\0';
+            block[stored].course[sizeof(block[stored].course) - 1] = '\0';
+            if (!put_student(loaded + stored, &block[stored])) break;
         }
+        loaded += stored;
+        if (stored < n) break;
     }
-
-    if (index == -1) {
-        printf("Error: Student with ID %d not found.\n", id_to_update);
-        return;
+    free(block);
+    if (loaded < saved_count) {
+        printf("Error reading all records from file.\n");
     }
-
-    // Pointer to the specific student for easier access
-    Student *s = &student_list[index];
     
-    printf("Student Found: %s (Current GPA: %.2f)\n", s->name, s->gpa);
-    printf("What would you like to update?\n");
-    printf("1. Name\n");
-    printf("2. Age\n");
-    printf("3. Course\n");
-    printf("4. Grades (Recalculates GPA)\n");
-    printf("0. Cancel\n");
-    printf("Enter choice: ");
+    student_count = loaded;
+    student_slots = loaded;
+    id_index_invalidate();
+    name_index_invalidate();
+    display_order_active = 0;
+    fclose(fp);
+    printf("\nSuccessfully loaded %d records from %s.\n", student_count, FILENAME);
+}
 
-    int choice;
-    if (scanf("%d", &choice) != 1) {
-        printf("Invalid choice.\n");
-        while (getchar() != '\n');
-        return;
-    }
+// Loads the store (or the legacy file) and replays the write-ahead log over
+// it. If the store is unreadable the log is left alone and nothing is logged.
+void load_records() {
+    wal_close();
+    wal_restore_pages();
+    int status = load_store();
+    if (status == 0) load_legacy_records();
+    if (status >= 0) wal_open(store_header.generation);
+}
 
-    while (getchar() != '\n'); 
+void cleanup_memory() {
+    wal_close();
+    release_columns();
+    student_capacity = 0;
+    student_slots = 0;
+    free(free_slots);
+    free_slots = NULL;
+    free_count = 0;
+    free_capacity = 0;
+    free(id_index);
+    id_index = NULL;
+    id_index_capacity = 0;
+    id_index_stale = 1;
+    free(name_index);
+    name_index = NULL;
+    name_index_capacity = 0;
+    name_index_invalidate();
+    range_index_clear();
+    free(report_courses);
+    report_courses = NULL;
+    report_course_capacity = 0;
+    report_totals_stale = 1;
+    free(display_order);
+    display_order = NULL;
+    display_order_capacity = 0;
+    display_order_count = 0;
+    free(display_rank);
+    display_rank = NULL;
+    display_rank_capacity = 0;
+    display_order_active = 0;
+    course_clear();
+}
 
-    switch (choice) {
-        case 1: // Update Name
-            printf("Enter New Name: ");
-            fgets(s->name, 50, stdin);
-            s->name[strcspn(s->name, "\n")] = 0; 
-            printf("Name updated successfully.\n");
-            break;
+// Server Mode
+// run_server loads the roster, publishes a snapshot of it and serves
+// clients until SIGINT or SIGTERM, then saves. The main thread is the
+// writer: it is the only one touching the roster, indexes and log. Each
+// client has a thread of its own, which answers reads from the snapshot
+// current when the request arrived, so a long REPORT never holds up
+// writes, and queues writes for the writer, waiting for their replies.
+// A write is acknowledged once it is in the log on disk and visible to
+// later reads.
 
-        case 2: // Update Age
-            printf("Enter New Age: ");
-            int new_age;
-            if (scanf("%d", &new_age) == 1 && new_age >= 18 && new_age <= 99) {
-                s->age = new_age;
-                printf("Age updated successfully.\n");
-            } else {
-                printf("Invalid age input. Update failed.\n");
-            }
-            break;
+// Flags the chunks holding positions [first, first + count) as changed
+void snapshot_mark(int first, int count) {
+    int last = (first + count - 1) / SNAPSHOT_CHUNK;
+    for (int c = first / SNAPSHOT_CHUNK; c <= last && c < snapshot_dirty_count; c++) {
+        snapshot_dirty[c] = 1;
+    }
+}
 
-        case 3: // Update Course
-            printf("Enter New Course: ");
-            fgets(s->course, 50, stdin);
-            s->course[strcspn(s->course, "\n")] = 0;
-            printf("Course updated successfully.\n");
-            break;
+// Copies the positions from first on into a new chunk
+static SnapshotChunk *snapshot_chunk_build(int first) {
+    SnapshotChunk *chunk = (SnapshotChunk *)malloc(sizeof(SnapshotChunk));
+    if (chunk == NULL) return NULL;
+    chunk->refs = 1;
+    chunk->used = student_slots - first < SNAPSHOT_CHUNK ? student_slots - first : SNAPSHOT_CHUNK;
+    memset(chunk->id_table, 0, sizeof(chunk->id_table));
 
-        case 4: // Update Grades
-            printf("Enter %d New Grades (0.0 - 4.0):\n", MAX_GRADES);
-            for (int i = 0; i < MAX_GRADES; i++) {
-                do {
-                    printf("  Grade %d: ", i + 1);
-                    if (scanf("%f", &s->grades[i]) != 1 || s->grades[i] < 0.0 || s->grades[i] > 4.0) {
-                        printf("Invalid grade. Try again.\n");
-                        while (getchar() != '\n');
-                    } else {
-                        break;
-                    }
-                } while (1);
-            }
-            
-	    // Recalculate GPA after changing grades
-            s->gpa = calculate_gpa(s->grades);
-            printf("Grades updated. New GPA is %.2f.\n", s->gpa);
-            break;
+    unsigned int mask = SNAPSHOT_ID_TABLE - 1;
+    for (int r = 0; r < chunk->used; r++) {
+        int slot = first + r;
+        SnapshotRow *row = &chunk->rows[r];
+        row->live = student_live[slot];
+        if (!row->live) continue;
+        row->id = student_ids[slot];
+        row->age = student_ages[slot];
+        row->course = student_course_ids[slot];
+        row->gpa = student_gpas[slot];
+        row->details = student_details[slot];
 
-        case 0:
-            printf("Update cancelled.\n");
-            break;
+        unsigned int i = id_hash(row->id) & mask;
+        while (chunk->id_table[i] != 0) i = (i + 1) & mask;
+        chunk->id_table[i] = (uint16_t)(r + 1);
+    }
+    return chunk;
+}
 
-        default:
-            printf("Invalid selection.\n");
+// Drops a reference to s, freeing it and the chunks only it held with
+// the last one
+static void snapshot_release(Snapshot *s) {
+    if (s == NULL) return;
+    pthread_mutex_lock(&snapshot_lock);
+    int last = --s->refs == 0;
+    for (int c = 0; last && c < s->chunk_count; c++) {
+        if (--s->chunks[c]->refs == 0) free(s->chunks[c]);
+    }
+    pthread_mutex_unlock(&snapshot_lock);
+    if (last) {
+        free(s->chunks);
+        free(s->course_names);
+        free(s);
     }
 }
 
-// Search and Sorting Algorithms
-void search_records() {
-    int choice;
-    printf("Search by: 1. ID | 2. Name: ");
-    if (scanf("%d", &choice) != 1) {
-        printf("Invalid choice.\n");
-        return;
+// A reference to the current snapshot, for snapshot_release
+static Snapshot *snapshot_acquire(void) {
+    pthread_mutex_lock(&snapshot_lock);
+    Snapshot *s = snapshot_current;
+    if (s != NULL) s->refs++;
+    pthread_mutex_unlock(&snapshot_lock);
+    return s;
+}
+
+// Publishes the roster as it stands, reusing the chunks of the current
+// snapshot that have not changed since. Returns 0 if out of memory; the
+// current snapshot then stays, and its changed chunks stay flagged.
+static int snapshot_publish(void) {
+    Snapshot *old = snapshot_current;
+    int chunk_count = (student_slots + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK;
+    Snapshot *s = (Snapshot *)calloc(1, sizeof(Snapshot));
+    unsigned char *dirty = (unsigned char *)calloc(chunk_count + 1, 1);
+    if (s == NULL || dirty == NULL ||
+        (s->chunks = (SnapshotChunk **)calloc(chunk_count + 1, sizeof(SnapshotChunk *))) == NULL ||
+        (s->course_names = (char (*)[COURSE_NAME_SIZE])malloc((course_count + 1) * COURSE_NAME_SIZE)) == NULL) {
+        if (s != NULL) free(s->chunks);
+        free(s);
+        free(dirty);
+        return 0;
     }
-    
-    if (choice == 1) {
-        int id_search;
-        printf("Enter ID to search: ");
-        if (scanf("%d", &id_search) != 1) {
-            printf("Invalid input.\n");
-            return;
+    s->refs = 1;
+    s->count = student_count;
+    s->course_count = course_count;
+    for (int c = 0; c < course_count; c++) memcpy(s->course_names[c], courses[c].name, COURSE_NAME_SIZE);
+
+    // A chunk is reused if unchanged and still the same length (compaction
+    // can end the roster part way through one without touching it)
+    int ok = 1;
+    for (int c = 0; c < chunk_count && ok; c++) {
+        int used = student_slots - c * SNAPSHOT_CHUNK < SNAPSHOT_CHUNK ? student_slots - c * SNAPSHOT_CHUNK : SNAPSHOT_CHUNK;
+        if (old != NULL && c < old->chunk_count && c < snapshot_dirty_count && !snapshot_dirty[c] &&
+            old->chunks[c]->used == used) {
+            continue;
         }
-        
-        // Linear Search
-        for (int i = 0; i < student_count; i++) {
-            if (student_list[i].id == id_search) {
-                printf("\n--- Found Student ---\n");
-                printf("ID: %d, Name: %s, GPA: %.2f\n", 
-                       student_list[i].id, student_list[i].name, student_list[i].gpa);
-                return;
-            }
+        ok = (s->chunks[c] = snapshot_chunk_build(c * SNAPSHOT_CHUNK)) != NULL;
+    }
+    if (!ok) {
+        for (int c = 0; c < chunk_count; c++) free(s->chunks[c]);
+        free(s->chunks);
+        free(s->course_names);
+        free(s);
+        free(dirty);
+        return 0;
+    }
+
+    pthread_mutex_lock(&snapshot_lock);
+    for (int c = 0; c < chunk_count; c++) {
+        if (s->chunks[c] == NULL) {
+            s->chunks[c] = old->chunks[c];
+            s->chunks[c]->refs++;
         }
-        printf("Student with ID %d not found.\n", id_search);
+    }
+    s->chunk_count = chunk_count;
+    snapshot_current = s;
+    pthread_mutex_unlock(&snapshot_lock);
+    snapshot_release(old);
 
-    } else if (choice == 2) {
-        char name_search[50];
-        printf("Enter Name to search: ");
-        while (getchar() != '\n');
-        fgets(name_search, 50, stdin);
-        name_search[strcspn(name_search, "\n")] = 0;
+    free(snapshot_dirty);
+    snapshot_dirty = dirty;
+    snapshot_dirty_count = chunk_count;
+    return 1;
+}
 
-        for (int i = 0; i < student_count; i++) {
-            if (strcmp(student_list[i].name, name_search) == 0) {
-                printf("\n--- Found Student ---\n");
-                printf("ID: %d, Name: %s, GPA: %.2f\n", 
-                       student_list[i].id, student_list[i].name, student_list[i].gpa);
-                return;
-            }
+// Live row of the student with this id in s, or NULL
+static const SnapshotRow *snapshot_find(const Snapshot *s, int id) {
+    unsigned int mask = SNAPSHOT_ID_TABLE - 1;
+    unsigned int home = id_hash(id) & mask;
+    for (int c = 0; c < s->chunk_count; c++) {
+        const SnapshotChunk *chunk = s->chunks[c];
+        for (unsigned int i = home; chunk->id_table[i] != 0; i = (i + 1) & mask) {
+            const SnapshotRow *row = &chunk->rows[chunk->id_table[i] - 1];
+            if (row->id == id) return row;
         }
-        printf("Student with name '%s' not found.\n", name_search);
     }
+    return NULL;
 }
 
-// Bubble Sort Implementation
-void sort_records() {
-    if (student_count < 2) {
-        printf("Need at least 2 students to sort.\n");
-        return;
+static void snapshot_format_row(ExportChunk *out, FloatCache *cache, const Snapshot *s, const SnapshotRow *row) {
+    export_record(out, cache, row->id, &row->details, row->age, s->course_names[row->course], row->gpa);
+}
+
+// Whether name contains text, ignoring case
+static int name_contains(const char *name, const char *text) {
+    size_t length = strlen(text);
+    if (length == 0) return 1;
+    int first = tolower((unsigned char)text[0]);
+    for (const char *p = name; *p != '\0'; p++) {
+        if (tolower((unsigned char)*p) == first && strncasecmp(p + 1, text + 1, length - 1) == 0) return 1;
     }
-    
-    int choice;
-    printf("Sort by: 1. GPA | 2. ID | 3. Name: ");
-    if (scanf("%d", &choice) != 1) {
-        printf("Invalid input.\n");
-        while(getchar() != '\n');
-        return;
+    return 0;
+}
+
+// REPORT: a "total" line (students, average GPA, lowest GPA, best student
+// and GPA), then a "course" line per course (name, students, average GPA,
+// top performer and GPA) in order of first enrolment, as generate_reports
+// prints them
+static int server_report(const Snapshot *s, ExportChunk *out) {
+    CourseGroup *groups = (CourseGroup *)calloc(s->course_count + 1, sizeof(CourseGroup));
+    const SnapshotRow **tops = (const SnapshotRow **)calloc(s->course_count + 1, sizeof(SnapshotRow *));
+    int *ordered = (int *)malloc((s->course_count + 1) * sizeof(int));
+    if (groups == NULL || tops == NULL || ordered == NULL) {
+        free(groups);
+        free(tops);
+        free(ordered);
+        return -1;
     }
-    
-    // Bubble Sort Algorithm
-    for (int i = 0; i < student_count - 1; i++) {
-        for (int j = 0; j < student_count - 1 - i; j++) {
-            int swap = 0;
-            
-            if (choice == 1 && student_list[j].gpa < student_list[j+1].gpa) { // Sort by GPA (Descending)
-                swap = 1;
-            } else if (choice == 2 && student_list[j].id > student_list[j+1].id) { // Sort by ID (Ascending)
-                swap = 1;
-            } else if (choice == 3 && strcmp(student_list[j].name, student_list[j+1].name) > 0) { // Sort by Name (Ascending)
-                swap = 1;
+
+    double gpa_sum = 0;
+    float max_gpa = -1.0f, min_gpa = 5.0f;
+    const SnapshotRow *best = NULL;
+    int count = 0;
+    for (int c = 0; c < s->chunk_count; c++) {
+        const SnapshotChunk *chunk = s->chunks[c];
+        for (int r = 0; r < chunk->used; r++) {
+            const SnapshotRow *row = &chunk->rows[r];
+            if (!row->live) continue;
+            gpa_sum += row->gpa;
+            if (row->gpa > max_gpa) {
+                max_gpa = row->gpa;
+                best = row;
             }
+            if (row->gpa < min_gpa) min_gpa = row->gpa;
 
-            if (swap) {
-                Student temp = student_list[j];
-                student_list[j] = student_list[j+1];
-                student_list[j+1] = temp;
+            CourseGroup *g = &groups[row->course];
+            if (g->count++ == 0) {
+                g->max_gpa = -1.0f;
+                ordered[count++] = row->course;
+            }
+            g->gpa_sum += row->gpa;
+            if (row->gpa > g->max_gpa) {
+                g->max_gpa = row->gpa;
+                tops[row->course] = row;
             }
         }
     }
 
-    printf("Records sorted by ");
-    if (choice == 1) printf("GPA (highest first).\n");
-    else if (choice == 2) printf("ID (ascending).\n");
-    else if (choice == 3) printf("Name (A-Z).\n");
+    FloatCache cache;
+    memset(&cache, 0, sizeof(cache));
+    int lines = 0;
+    if (s->count > 0) {
+        export_append(out, "total,", 6);
+        export_int(out, s->count);
+        export_append(out, ",", 1);
+        export_gpa(out, (float)(gpa_sum / s->count));
+        export_append(out, ",", 1);
+        export_gpa(out, min_gpa);
+        export_append(out, ",", 1);
+        export_text(out, best != NULL ? best->details.name : "N/A");
+        export_append(out, ",", 1);
+        export_gpa(out, max_gpa);
+        export_append(out, "\n", 1);
+        lines++;
+    }
+    for (int i = 0; i < count; i++) {
+        const CourseGroup *g = &groups[ordered[i]];
+        export_append(out, "course,", 7);
+        export_text(out, s->course_names[ordered[i]]);
+        export_append(out, ",", 1);
+        export_int(out, g->count);
+        export_append(out, ",", 1);
+        export_gpa(out, (float)(g->gpa_sum / g->count));
+        export_append(out, ",", 1);
+        export_text(out, tops[ordered[i]] != NULL ? tops[ordered[i]]->details.name : "N/A");
+        export_append(out, ",", 1);
+        export_gpa(out, g->max_gpa);
+        export_append(out, "\n", 1);
+        lines++;
+    }
+    free(groups);
+    free(tops);
+    free(ordered);
+    return lines;
 }
 
-// Statistical and Analytical Features
-void generate_reports() {
-    if (student_count == 0) {
-        printf("No student data available for reports.\n");
-        return;
-    }
+// Answers a read from the current snapshot. Returns 0 if verb is not one.
+static int server_read(const char *verb, const char *arg, FILE *out) {
+    int get = strcmp(verb, "GET") == 0, find = strcmp(verb, "FIND") == 0;
+    int list = strcmp(verb, "LIST") == 0, report = strcmp(verb, "REPORT") == 0;
+    if (!get && !find && !list && !report) return 0;
 
-    // --- Part 1: Class-wide Statistics ---
-    float total_gpa = 0;
-    float max_gpa = -1.0;
-    float min_gpa = 5.0;
-    int top_student_index = -1;
+    int id = 0;
+    if (get && !parse_int(arg, &id)) {
+        fprintf(out, "ERR %s\n", IMPORT_BAD_ID);
+        return 1;
+    }
+    Snapshot *s = snapshot_acquire();
+    ExportChunk body;
+    memset(&body, 0, sizeof(body));
+    FloatCache cache;
+    memset(&cache, 0, sizeof(cache));
+    int lines = 0;
 
-    for (int i = 0; i < student_count; i++) {
-        total_gpa += student_list[i].gpa;
-        
-        // Check for Global Max
-        if (student_list[i].gpa > max_gpa) {
-            max_gpa = student_list[i].gpa;
-            top_student_index = i;
+    if (report) {
+        lines = server_report(s, &body);
+    } else if (get) {
+        const SnapshotRow *row = snapshot_find(s, id);
+        if (row != NULL) {
+            snapshot_format_row(&body, &cache, s, row);
+            lines = 1;
         }
-        // Check for Global Min
-        if (student_list[i].gpa < min_gpa) {
-            min_gpa = student_list[i].gpa;
+    } else {
+        for (int c = 0; c < s->chunk_count && !body.out_of_memory; c++) {
+            const SnapshotChunk *chunk = s->chunks[c];
+            for (int r = 0; r < chunk->used; r++) {
+                const SnapshotRow *row = &chunk->rows[r];
+                if (!row->live || (find && !name_contains(row->details.name, arg))) continue;
+                snapshot_format_row(&body, &cache, s, row);
+                lines++;
+            }
         }
     }
+    snapshot_release(s);
 
-    printf("-- Performance Report --\n");
-    printf("Total Students:      %d\n", student_count);
-    printf("Overall Average GPA: %.2f\n", total_gpa / student_count);
-    if (top_student_index != -1) {
-        printf("Best Student Overall: %s (GPA: %.2f)\n", 
-               student_list[top_student_index].name, max_gpa);
+    if (lines < 0 || body.out_of_memory) {
+        fprintf(out, "ERR not enough memory\n");
+    } else if (get && lines == 0) {
+        fprintf(out, "ERR student %d not found\n", id);
+    } else {
+        fprintf(out, "OK %d\n", lines);
+        if (body.length > 0) fwrite(body.text, 1, body.length, out);
     }
-    printf("Lowest Class GPA:    %.2f\n", min_gpa);
-
-
-    // Course Analysis 
-    printf("\n-- Analysis by Course --\n");
+    free(body.text);
+    return 1;
+}
 
-    for (int i = 0; i < student_count; i++) {
-        // 1. Duplicate Check:
-        // Check if we have already processed this course name in a previous iteration
-        int already_processed = 0;
-        for (int prev = 0; prev < i; prev++) {
-            if (strcmp(student_list[i].course, student_list[prev].course) == 0) {
-                already_processed = 1;
+// Applies one write on the writer thread and fills in its reply
+static void server_apply(ServerWrite *w) {
+    Student s;
+    char old_name[COURSE_NAME_SIZE], new_name[COURSE_NAME_SIZE];
+    const char *reason = NULL;
+    const char *p = w->arg, *end = w->arg + strlen(w->arg);
+    int id, slot;
+    switch (w->op) {
+        case SERVER_ADD:
+        case SERVER_UPDATE:
+            if ((reason = parse_csv_line(p, end, &s)) != NULL) break;
+            slot = find_student(s.id);
+            if (w->op == SERVER_ADD && slot >= 0) {
+                snprintf(w->reply, sizeof(w->reply), "ERR ID %d already exists", s.id);
+                return;
+            }
+            if (w->op == SERVER_UPDATE && slot < 0) {
+                snprintf(w->reply, sizeof(w->reply), "ERR student %d not found", s.id);
+                return;
+            }
+            if ((slot = upsert_student(&s)) < 0) {
+                reason = "not enough memory";
                 break;
             }
-        }
+            wal_log_student(slot);
+            break;
 
-        // If we have seen this course before, skip it to avoid duplicate reports
-        if (already_processed) continue;
+        case SERVER_DELETE:
+            if (!parse_int(w->arg, &id)) {
+                reason = IMPORT_BAD_ID;
+                break;
+            }
+            if ((slot = find_student(id)) < 0) {
+                snprintf(w->reply, sizeof(w->reply), "ERR student %d not found", id);
+                return;
+            }
+            remove_student(slot);
+            wal_log(WAL_DELETE, &id, sizeof(id));
+            break;
 
-        char *current_course = student_list[i].course;
-        
-        float course_total_gpa = 0;
-        int course_count = 0;
-        float course_max = -1.0;
-        char top_student_in_course[50];
-        strcpy(top_student_in_course, "N/A");
-
-        // Loop through the ENTIRE list again to find matches for this course
-        for (int j = 0; j < student_count; j++) {
-            if (strcmp(student_list[j].course, current_course) == 0) {
-                course_total_gpa += student_list[j].gpa;
-                course_count++;
-                
-                if (student_list[j].gpa > course_max) {
-                    course_max = student_list[j].gpa;
-                    strcpy(top_student_in_course, student_list[j].name);
-                }
+        case SERVER_RENAME:
+            if (csv_field(&p, end, old_name, sizeof(old_name)) != 1 ||
+                csv_field(&p, end, new_name, sizeof(new_name)) != 0) {
+                reason = "expected OLD,NEW course names";
+            } else if ((id = course_lookup(old_name)) < 0) {
+                reason = "course not found";
+            } else if (!course_rename(id, new_name)) {
+                reason = "course already exists";
+            } else {
+                wal_log_rename(old_name, new_name);
             }
-        }
+            break;
 
-        printf("Course: %-15s\n", current_course);
-        printf("   - Students Enrolled: %d\n", course_count);
-        printf("   - Average GPA:       %.2f\n", course_total_gpa / course_count);
-        printf("   - Top Performer:     %s (%.2f)\n", top_student_in_course, course_max);
+        case SERVER_SAVE:
+            if (wal_unapplied) reason = "write-ahead log not fully applied";
+            else save_records();
+            break;
     }
+    if (reason != NULL) snprintf(w->reply, sizeof(w->reply), "ERR %s", reason);
+    else snprintf(w->reply, sizeof(w->reply), "OK 0");
 }
 
-// File Handling
+// Queues a write for the writer and sends its reply. Returns 0 if verb is
+// not one.
+static int server_write(const char *verb, const char *arg, FILE *out) {
+    static const char *const verbs[] = { "ADD", "UPDATE", "DELETE", "RENAME", "SAVE" };
+    ServerWrite w;
+    memset(&w, 0, sizeof(w));
+    int op = 0;
+    while (op < (int)(sizeof(verbs) / sizeof(verbs[0])) && strcmp(verb, verbs[op]) != 0) op++;
+    if (op == (int)(sizeof(verbs) / sizeof(verbs[0]))) return 0;
+    w.op = (ServerOp)op;
+    w.arg = arg;
 
-void save_records() {
-    FILE *fp = fopen(FILENAME, "w"); 
-    if (fp == NULL) {
-        perror("Error opening file for saving");
-        return;
+    pthread_mutex_lock(&server_lock);
+    if (server_stop) {
+        snprintf(w.reply, sizeof(w.reply), "ERR server is shutting down");
+    } else {
+        if (server_queue_tail != NULL) server_queue_tail->next = &w;
+        else server_queue_head = &w;
+        server_queue_tail = &w;
+        pthread_cond_signal(&server_queued);
+        while (!w.done) pthread_cond_wait(&server_replied, &server_lock);
     }
+    pthread_mutex_unlock(&server_lock);
+    fprintf(out, "%s\n", w.reply);
+    return 1;
+}
 
-    // Write the total number of records first
-    fwrite(&student_count, sizeof(int), 1, fp);
+// Client thread body: answers requests until the client hangs up, sends
+// QUIT or the server stops
+static void *server_client(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    int out_fd = dup(fd);
+    FILE *in = fdopen(fd, "r");
+    FILE *out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+    char line[SERVER_LINE_SIZE];
+    while (in != NULL && out != NULL && fgets(line, sizeof(line), in) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        if (line[length] == '\0' && length == sizeof(line) - 1) {
+            int c;
+            while ((c = getc(in)) != EOF && c != '\n') {
+            }
+            fprintf(out, "ERR request is too long\n");
+        } else {
+            line[length] = '\0';
+            char *request_arg = strchr(line, ' ');
+            if (request_arg != NULL) *request_arg++ = '\0';
+            else request_arg = line + length;
+            if (strcmp(line, "QUIT") == 0) break;
+            if (!server_read(line, request_arg, out) && !server_write(line, request_arg, out)) {
+                fprintf(out, "ERR unknown request %s\n", line);
+            }
+        }
+        if (fflush(out) != 0) break;
+    }
 
-    // Write the entire array block
-    if (student_count > 0) {
-        fwrite(student_list, sizeof(Student), student_count, fp);
+    pthread_mutex_lock(&server_lock);
+    for (int i = 0; i < server_clients; i++) {
+        if (server_client_fds[i] == fd) server_client_fds[i] = server_client_fds[--server_clients];
     }
-    
-    fclose(fp);
-    printf("\nSuccessfully saved %d records to %s.\n", student_count, FILENAME);
+    if (in != NULL) fclose(in);
+    else close(fd);
+    if (out != NULL) fclose(out);
+    else if (out_fd >= 0) close(out_fd);
+    pthread_cond_broadcast(&server_replied);
+    pthread_mutex_unlock(&server_lock);
+    return NULL;
 }
 
-void load_records() {
-    FILE *fp = fopen(FILENAME, "r");
-    if (fp == NULL) {
-        perror("Error opening file for loading. Starting with empty list.");
-        return;
+// Acceptor thread body: starts a client thread per connection until the
+// listening socket is shut down
+static void *server_accept(void *arg) {
+    int listen_fd = (int)(intptr_t)arg;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        pthread_mutex_lock(&server_lock);
+        int admitted = !server_stop && server_clients < SERVER_MAX_CLIENTS;
+        if (admitted) server_client_fds[server_clients++] = fd;
+        pthread_t thread;
+        if (admitted && pthread_create(&thread, &attr, server_client, (void *)(intptr_t)fd) != 0) {
+            server_clients--;
+            admitted = 0;
+        }
+        pthread_mutex_unlock(&server_lock);
+        if (!admitted) {
+            static const char refusal[] = "ERR server is busy\n";
+            if (write(fd, refusal, sizeof(refusal) - 1) < 0) {
+                // The client is gone already
+            }
+            close(fd);
+        }
     }
+    pthread_attr_destroy(&attr);
+    return NULL;
+}
 
-    // Read the total number of records
-    int saved_count = 0;
-    if (fread(&saved_count, sizeof(int), 1, fp) != 1) {
-        printf("File is empty or corrupted.\n");
-        fclose(fp);
-        return;
-    }
+// The signals that stop the server. They are blocked before the first
+// thread starts, so that only server_signals, through sigwait, takes them.
+void server_signal_set(sigset_t *signals) {
+    sigemptyset(signals);
+    sigaddset(signals, SIGINT);
+    sigaddset(signals, SIGTERM);
+}
 
-    if (saved_count > student_capacity) {
-        student_capacity = saved_count;
-        Student *temp = (Student *)realloc(student_list, student_capacity * sizeof(Student));
-        if (temp == NULL) {
-            perror("Error reallocating memory for loaded data");
-            fclose(fp);
-            return;
+// Signal thread body: turns SIGINT or SIGTERM into a stop
+static void *server_signals(void *arg) {
+    sigset_t *signals = (sigset_t *)arg;
+    int signal_number;
+    sigwait(signals, &signal_number);
+    pthread_mutex_lock(&server_lock);
+    server_stop = 1;
+    pthread_cond_signal(&server_queued);
+    pthread_mutex_unlock(&server_lock);
+    return NULL;
+}
+
+// Writer loop: applies queued writes in batches until server_stop
+static void server_write_loop(void) {
+    pthread_mutex_lock(&server_lock);
+    for (;;) {
+        while (server_queue_head == NULL && !server_stop) pthread_cond_wait(&server_queued, &server_lock);
+        if (server_stop) break;
+        ServerWrite *batch = server_queue_head;
+        server_queue_head = server_queue_tail = NULL;
+        pthread_mutex_unlock(&server_lock);
+
+        for (ServerWrite *w = batch; w != NULL; w = w->next) server_apply(w);
+        if (!wal_sync()) wal_report_failure();
+        if (!snapshot_publish()) printf("Error: Not enough memory to publish a snapshot.\n");
+        wal_checkpoint_if_due();
+
+        // A client may return as soon as its write is done: read next first
+        pthread_mutex_lock(&server_lock);
+        for (ServerWrite *w = batch, *next; w != NULL; w = next) {
+            next = w->next;
+            w->done = 1;
         }
-        student_list = temp;
+        pthread_cond_broadcast(&server_replied);
+    }
+    for (ServerWrite *w = server_queue_head, *next; w != NULL; w = next) {
+        next = w->next;
+        snprintf(w->reply, sizeof(w->reply), "ERR server is shutting down");
+        w->done = 1;
     }
+    server_queue_head = server_queue_tail = NULL;
+    pthread_cond_broadcast(&server_replied);
+    pthread_mutex_unlock(&server_lock);
+}
 
-    // Read the entire array block
-    if (fread(student_list, sizeof(Student), saved_count, fp) != saved_count) {
-        printf("Error reading all records from file.\n");
-        fclose(fp);
-        return;
+static int server_listen(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Error: Socket path %s is too long.\n", path);
+        return -1;
     }
-    
-    student_count = saved_count;
-    fclose(fp);
-    printf("\nSuccessfully loaded %d records from %s.\n", student_count, FILENAME);
+    strcpy(addr.sun_path, path);
+
+    // Replace a socket left by an earlier run, but nothing else
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("Error opening server socket");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
 }
 
-void cleanup_memory() {
-    if (student_list != NULL) {
-        free(student_list);
-        student_list = NULL;
+// Serves the loaded roster on the Unix domain socket at path until
+// SIGINT or SIGTERM. Returns 0 if the server could not start.
+int run_server(const char *path) {
+    if (!snapshot_publish()) {
+        printf("Error: Not enough memory to start the server.\n");
+        return 0;
     }
+    int listen_fd = server_listen(path);
+    if (listen_fd < 0) {
+        snapshot_release(snapshot_current);
+        snapshot_current = NULL;
+        return 0;
+    }
+
+    // A client hanging up mid-reply shows up as a write error instead
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t signals;
+    server_signal_set(&signals);
+    server_stop = 0;
+    pthread_t signal_thread, accept_thread;
+    int ok = pthread_create(&signal_thread, NULL, server_signals, &signals) == 0;
+    int accepting = ok && pthread_create(&accept_thread, NULL, server_accept, (void *)(intptr_t)listen_fd) == 0;
+    if (accepting) {
+        printf("Serving %d records on %s.\n", student_count, path);
+        fflush(stdout);
+        server_write_loop();
+    } else {
+        printf("Error: Could not start the server threads.\n");
+        if (ok) pthread_kill(signal_thread, SIGTERM);
+    }
+
+    // Stop accepting, hang up on every client and wait for their threads
+    shutdown(listen_fd, SHUT_RDWR);
+    if (accepting) pthread_join(accept_thread, NULL);
+    if (ok) pthread_join(signal_thread, NULL);
+    close(listen_fd);
+    unlink(path);
+    pthread_mutex_lock(&server_lock);
+    for (int i = 0; i < server_clients; i++) shutdown(server_client_fds[i], SHUT_RDWR);
+    while (server_clients > 0) pthread_cond_wait(&server_replied, &server_lock);
+    pthread_mutex_unlock(&server_lock);
+
+    snapshot_release(snapshot_current);
+    snapshot_current = NULL;
+    free(snapshot_dirty);
+    snapshot_dirty = NULL;
+    snapshot_dirty_count = 0;
+    if (accepting) printf("Server stopped.\n");
+    return accepting;
 }
 
 // Main Function & Menu
@@ -558,16 +4632,42 @@ void display_menu() {
     printf("7. Generate Reports & Statistics\n");
     printf("8. Save Records to File\n");
     printf("9. Load Records from File\n");
+    printf("10. Rename Course\n");
     printf("0. Exit and Cleanup\n");
     printf("Enter choice: ");
 }
 
-int main() {
+// Non-interactive commands: import a CSV file and save, or export one
+int run_batch(int argc, char *argv[]) {
+    int import = argc == 3 && strcmp(argv[1], "import") == 0;
+    int serve = argc == 3 && strcmp(argv[1], "serve") == 0;
+    if (argc != 3 || (!import && !serve && strcmp(argv[1], "export") != 0)) {
+        fprintf(stderr, "Usage: %s [import FILE.csv | export FILE.csv | serve SOCKET]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (serve) {
+        sigset_t signals;
+        server_signal_set(&signals);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    }
+    initialize_list();
+    load_records();
+    int ok = serve ? run_server(argv[2]) : import ? import_csv(argv[2]) : export_csv(argv[2]);
+    if ((import || serve) && ok) save_records();
+    cleanup_memory();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) return run_batch(argc, argv);
+
     initialize_list();
     load_records(); 
     
     int choice;
     do {
+        store_report_damage();
         display_menu();
         if (scanf("%d", &choice) != 1) {
             printf("Invalid input. Please enter a number.\n");
@@ -585,9 +4685,11 @@ int main() {
             case 7: generate_reports(); break;
             case 8: save_records(); break;
             case 9: load_records(); break;
+            case 10: rename_course(); break;
             case 0: break;
             default: printf("Invalid choice. Try again.\n");
         }
+        if (choice != 0) wal_checkpoint_if_due();
     } while (choice != 0);
 
     save_records(); 